@@ -0,0 +1,30 @@
+# Преобразует файл шрифта в исходник C++ с массивом байтов.
+# Вызов: cmake -DINPUT=<шрифт> -DOUTPUT=<файл .cpp> -P EmbedFont.cmake
+
+if(NOT INPUT OR NOT OUTPUT)
+    message(FATAL_ERROR "EmbedFont.cmake: INPUT and OUTPUT are required")
+endif()
+
+get_filename_component(font_name "${INPUT}" NAME)
+file(SIZE "${INPUT}" font_size)
+file(READ "${INPUT}" font_hex HEX)
+
+# По 16 байт на строку (регулярные выражения CMake не поддерживают {n})
+string(REPEAT "[0-9a-f][0-9a-f]" 16 line_pattern)
+string(REGEX REPLACE "(${line_pattern})" "\\1\n" font_hex "${font_hex}")
+string(REGEX REPLACE "([0-9a-f][0-9a-f])" "0x\\1," font_bytes "${font_hex}")
+string(REPLACE "\n" "\n    " font_bytes "${font_bytes}")
+
+file(WRITE "${OUTPUT}"
+"// Сгенерировано cmake/EmbedFont.cmake из ${font_name}, не редактировать
+#include <cstddef>
+
+namespace embedded_font {
+    extern const unsigned char data[] = {
+    ${font_bytes}
+    };
+    extern const size_t size = ${font_size};
+    extern const char name[] = \"${font_name}\";
+}
+")
+
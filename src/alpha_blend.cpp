@@ -0,0 +1,161 @@
+#include "alpha_blend.h"
+#include <cstddef>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define ALPHA_BLEND_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define ALPHA_BLEND_TARGET_AVX2
+#else
+#define ALPHA_BLEND_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace blend {
+
+namespace {
+    // Строка обрабатывается блоками по 32 пикселя (96 байт): шаблон цвета
+    // тогда совпадает с началом каждого блока
+    const int CHUNK_PIXELS = 32;
+
+    typedef void (*ChunkKernel)(unsigned char* rgb, const unsigned char* alpha, size_t bytes, const unsigned char* pattern);
+
+    void blendChunkScalar(unsigned char* rgb, const unsigned char* alpha, size_t bytes, const unsigned char* pattern) {
+        for (size_t i = 0; i < bytes; ++i) {
+            rgb[i] = blendChannel(rgb[i], pattern[i], alpha[i]);
+        }
+    }
+
+#ifdef ALPHA_BLEND_X86
+    // 8 каналов в 16-битных словах: (d * (255 - a) + c * a + 128) / 255
+    inline __m128i blendWords(__m128i d, __m128i c, __m128i a) {
+        const __m128i max = _mm_set1_epi16(255);
+        const __m128i half = _mm_set1_epi16(128);
+        __m128i t = _mm_add_epi16(_mm_mullo_epi16(d, _mm_sub_epi16(max, a)), _mm_mullo_epi16(c, a));
+        t = _mm_add_epi16(t, half);
+        return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+    }
+
+    void blendChunkSse2(unsigned char* rgb, const unsigned char* alpha, size_t bytes, const unsigned char* pattern) {
+        const __m128i zero = _mm_setzero_si128();
+        size_t i = 0;
+        for (; i + 16 <= bytes; i += 16) {
+            __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rgb + i));
+            __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pattern + i));
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(alpha + i));
+            __m128i lo = blendWords(_mm_unpacklo_epi8(d, zero), _mm_unpacklo_epi8(c, zero), _mm_unpacklo_epi8(a, zero));
+            __m128i hi = blendWords(_mm_unpackhi_epi8(d, zero), _mm_unpackhi_epi8(c, zero), _mm_unpackhi_epi8(a, zero));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(rgb + i), _mm_packus_epi16(lo, hi));
+        }
+        blendChunkScalar(rgb + i, alpha + i, bytes - i, pattern + i);
+    }
+
+    ALPHA_BLEND_TARGET_AVX2
+    void blendChunkAvx2(unsigned char* rgb, const unsigned char* alpha, size_t bytes, const unsigned char* pattern) {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i max = _mm256_set1_epi16(255);
+        const __m256i half = _mm256_set1_epi16(128);
+        size_t i = 0;
+        for (; i + 32 <= bytes; i += 32) {
+            __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rgb + i));
+            __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pattern + i));
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(alpha + i));
+            // unpack/pack работают внутри 128-битных половин, поэтому порядок байт сохраняется
+            __m256i dl = _mm256_unpacklo_epi8(d, zero), dh = _mm256_unpackhi_epi8(d, zero);
+            __m256i cl = _mm256_unpacklo_epi8(c, zero), ch = _mm256_unpackhi_epi8(c, zero);
+            __m256i al = _mm256_unpacklo_epi8(a, zero), ah = _mm256_unpackhi_epi8(a, zero);
+            __m256i tl = _mm256_add_epi16(_mm256_mullo_epi16(dl, _mm256_sub_epi16(max, al)), _mm256_mullo_epi16(cl, al));
+            __m256i th = _mm256_add_epi16(_mm256_mullo_epi16(dh, _mm256_sub_epi16(max, ah)), _mm256_mullo_epi16(ch, ah));
+            tl = _mm256_add_epi16(tl, half);
+            th = _mm256_add_epi16(th, half);
+            tl = _mm256_srli_epi16(_mm256_add_epi16(tl, _mm256_srli_epi16(tl, 8)), 8);
+            th = _mm256_srli_epi16(_mm256_add_epi16(th, _mm256_srli_epi16(th, 8)), 8);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(rgb + i), _mm256_packus_epi16(tl, th));
+        }
+        if (i < bytes) {
+            blendChunkSse2(rgb + i, alpha + i, bytes - i, pattern + i);
+        }
+    }
+
+    bool cpuHasAvx2() {
+#if defined(_MSC_VER) && !defined(__clang__)
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7) {
+            return false;
+        }
+        __cpuid(info, 1);
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        bool avx = (info[2] & (1 << 28)) != 0;
+        if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) {
+            return false;
+        }
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#endif
+    }
+#endif
+
+    struct KernelChoice {
+        ChunkKernel kernel;
+        const char* name;
+    };
+
+    KernelChoice chooseKernel() {
+#ifdef ALPHA_BLEND_X86
+        if (cpuHasAvx2()) {
+            return {blendChunkAvx2, "avx2"};
+        }
+        return {blendChunkSse2, "sse2"};
+#else
+        return {blendChunkScalar, "scalar"};
+#endif
+    }
+
+    const KernelChoice& getKernel() {
+        static const KernelChoice choice = chooseKernel();
+        return choice;
+    }
+}
+
+BlendColor makeBlendColor(unsigned char r, unsigned char g, unsigned char b) {
+    BlendColor color;
+    for (int i = 0; i < 96; i += 3) {
+        color.pattern[i] = r;
+        color.pattern[i + 1] = g;
+        color.pattern[i + 2] = b;
+    }
+    return color;
+}
+
+void blendCoverageRow(unsigned char* rgb, const unsigned char* coverage, int pixels, const BlendColor& color) {
+    ChunkKernel kernel = getKernel().kernel;
+    unsigned char alpha[CHUNK_PIXELS * 3];
+
+    for (int start = 0; start < pixels; start += CHUNK_PIXELS) {
+        int count = pixels - start < CHUNK_PIXELS ? pixels - start : CHUNK_PIXELS;
+
+        // Покрытие размножается на три канала; полностью прозрачные блоки пропускаются
+        bool visible = false;
+        for (int i = 0; i < count; ++i) {
+            unsigned char a = coverage[start + i];
+            alpha[i * 3] = a;
+            alpha[i * 3 + 1] = a;
+            alpha[i * 3 + 2] = a;
+            visible |= a != 0;
+        }
+        if (visible) {
+            kernel(rgb + static_cast<size_t>(start) * 3, alpha, static_cast<size_t>(count) * 3, color.pattern);
+        }
+    }
+}
+
+const char* getKernelName() {
+    return getKernel().name;
+}
+
+}
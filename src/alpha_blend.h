@@ -0,0 +1,28 @@
+#ifndef ALPHA_BLEND_H
+#define ALPHA_BLEND_H
+
+// Наложение покрытия глифа на RGB-буфер в целочисленной арифметике с фиксированной точкой:
+// результат = (dst * (255 - a) + color * a) / 255 с округлением.
+// Реализация (AVX2, SSE2 или скалярная) выбирается один раз во время выполнения.
+namespace blend {
+    // Цвет текста, развернутый в шаблон RGBRGB... для векторных загрузок
+    struct BlendColor {
+        unsigned char pattern[96];
+    };
+
+    BlendColor makeBlendColor(unsigned char r, unsigned char g, unsigned char b);
+
+    // Смешивает pixels пикселей строки rgb (3 байта на пиксель) с цветом по покрытию coverage
+    void blendCoverageRow(unsigned char* rgb, const unsigned char* coverage, int pixels, const BlendColor& color);
+
+    // Эталонное скалярное смешивание одного канала
+    inline unsigned char blendChannel(unsigned char dst, unsigned char src, unsigned char alpha) {
+        unsigned int t = dst * (255u - alpha) + src * static_cast<unsigned int>(alpha) + 128u;
+        return static_cast<unsigned char>((t + (t >> 8)) >> 8);
+    }
+
+    // Имя выбранной реализации: "avx2", "sse2" или "scalar"
+    const char* getKernelName();
+}
+
+#endif
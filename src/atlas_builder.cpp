@@ -0,0 +1,273 @@
+#include "atlas_builder.h"
+#include "rect_packer.h"
+#include "thread_pool.h"
+#include "utils.h"
+#include "xml_parser.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+
+namespace {
+    double elapsedMs(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    std::string jsonEscape(const std::string& text) {
+        std::string result;
+        result.reserve(text.size() + 2);
+        for (unsigned char c : text) {
+            switch (c) {
+                case '"': result += "\\\""; break;
+                case '\\': result += "\\\\"; break;
+                case '\n': result += "\\n"; break;
+                case '\r': result += "\\r"; break;
+                case '\t': result += "\\t"; break;
+                default:
+                    if (c < 0x20) {
+                        char escaped[8];
+                        std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                        result += escaped;
+                    } else {
+                        result += static_cast<char>(c); // UTF-8 передается как есть
+                    }
+            }
+        }
+        return result;
+    }
+
+    // Ресурсы одного потока: у каждого свой FreeType
+    struct AtlasWorker {
+        XmlParser parser;
+        ImageGenerator generator;
+    };
+}
+
+AtlasBuilder::AtlasBuilder(const AtlasOptions& options)
+    : options_(options) {
+    if (options_.jobs < 1) {
+        options_.jobs = 1;
+    }
+    if (options_.padding < 0) {
+        options_.padding = 0;
+    }
+}
+
+void AtlasBuilder::add(const std::string& file, const std::string& relativePath) {
+    Block block;
+    block.file = file;
+    block.relativePath = relativePath;
+    blocks_.push_back(std::move(block));
+}
+
+std::string AtlasBuilder::getPageName(size_t page) const {
+    return options_.name + "_" + std::to_string(page) + ".png";
+}
+
+AtlasSummary AtlasBuilder::build() {
+    AtlasSummary summary;
+    std::mutex summaryMutex;
+
+    // Порядок блоков в индексе не зависит от порядка обхода директорий
+    std::sort(blocks_.begin(), blocks_.end(),
+              [](const Block& a, const Block& b) { return a.relativePath < b.relativePath; });
+
+    ThreadPool pool(static_cast<size_t>(options_.jobs));
+    std::vector<std::unique_ptr<AtlasWorker>> workers(pool.size());
+    auto getWorker = [&](size_t workerIndex) -> AtlasWorker& {
+        std::unique_ptr<AtlasWorker>& worker = workers[workerIndex];
+        if (!worker) {
+            utils::ScopedLogCapture capture; // Сообщения о загрузке шрифта не нужны
+            worker = std::make_unique<AtlasWorker>();
+            worker->generator.setMargin(options_.margin);
+        }
+        return *worker;
+    };
+
+    // 1. Разбор и разметка: размеры всех блоков нужны до упаковки
+    for (size_t i = 0; i < blocks_.size(); i++) {
+        pool.submit([&, i](size_t workerIndex) {
+            AtlasWorker& worker = getWorker(workerIndex);
+            Block& block = blocks_[i];
+            std::string log;
+            {
+                utils::ScopedLogCapture capture;
+                if (worker.parser.parseFile(block.file)) {
+                    block.name = worker.parser.getInterface().name;
+                    block.list = worker.generator.layoutDiagram(worker.parser.getInterface());
+                    worker.generator.getCanvasSize(block.list, block.width, block.height);
+                    block.ok = true;
+                }
+                log = capture.str();
+            }
+            if (!block.ok) {
+                std::lock_guard<std::mutex> lock(summaryMutex);
+                std::cerr << log << "[ERROR] Failed to parse: " << block.file << std::endl;
+                summary.errorCount++;
+            }
+        });
+    }
+    pool.wait();
+
+    // 2. Упаковка
+    std::vector<Page> pages = pack();
+
+    // 3. Растеризация прямо в буфер страницы и однократное кодирование
+    utils::createDirectoryIfNotExists(options_.outputDir);
+    std::vector<char> written(pages.size(), 0);
+    for (size_t p = 0; p < pages.size(); p++) {
+        pool.submit([&, p](size_t workerIndex) {
+            AtlasWorker& worker = getWorker(workerIndex);
+            const Page& page = pages[p];
+
+            auto start = std::chrono::steady_clock::now();
+            int stride = page.width * 3;
+            std::vector<unsigned char> pixels(static_cast<size_t>(stride) * page.height, 255);
+            for (size_t index : page.blocks) {
+                const Block& block = blocks_[index];
+                unsigned char* origin = pixels.data() + static_cast<size_t>(block.y) * stride + static_cast<size_t>(block.x) * 3;
+                worker.generator.renderToBuffer(block.list, origin, stride);
+            }
+            double rasterMs = elapsedMs(start);
+
+            start = std::chrono::steady_clock::now();
+            std::string path = options_.outputDir + "/" + getPageName(p);
+            bool ok = PngEncoder(options_.png).writeFile(path, pixels.data(), page.width, page.height, stride);
+            double encodeMs = elapsedMs(start);
+
+            written[p] = ok;
+            std::lock_guard<std::mutex> lock(summaryMutex);
+            summary.timings.rasterMs += rasterMs;
+            summary.timings.encodeMs += encodeMs;
+        });
+    }
+    pool.wait();
+
+    for (size_t p = 0; p < pages.size(); p++) {
+        std::string path = options_.outputDir + "/" + getPageName(p);
+        if (written[p]) {
+            std::cout << "Created atlas page: " << path << " (" << pages[p].width << "x" << pages[p].height
+                      << ", " << pages[p].blocks.size() << " blocks)" << std::endl;
+        } else {
+            std::cerr << "Failed to create PNG: " << path << std::endl;
+            summary.errorCount++;
+        }
+    }
+
+    if (!writeIndex(pages)) {
+        std::cerr << "Failed to write atlas index" << std::endl;
+        summary.errorCount++;
+    }
+
+    for (const Block& block : blocks_) {
+        if (block.ok) {
+            summary.blockCount++;
+        }
+    }
+    summary.pageCount = static_cast<int>(pages.size());
+    for (const auto& worker : workers) {
+        if (worker) {
+            GlyphCacheStats stats = worker->generator.getGlyphCacheStats();
+            summary.glyphStats.hits += stats.hits;
+            summary.glyphStats.misses += stats.misses;
+            summary.glyphStats.entries += stats.entries;
+            summary.timings.layoutMs += worker->generator.getTimings().layoutMs;
+        }
+    }
+    return summary;
+}
+
+// Блоки подаются по убыванию высоты; каждый кладется на первую страницу, где
+// он помещается. Блок больше страницы получает отдельную страницу своего размера.
+std::vector<AtlasBuilder::Page> AtlasBuilder::pack() {
+    std::vector<size_t> order;
+    for (size_t i = 0; i < blocks_.size(); i++) {
+        if (blocks_[i].ok) {
+            order.push_back(i);
+        }
+    }
+    std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+        if (blocks_[a].height != blocks_[b].height) {
+            return blocks_[a].height > blocks_[b].height;
+        }
+        return blocks_[a].width > blocks_[b].width;
+    });
+
+    std::vector<Page> pages;
+    std::vector<std::unique_ptr<SkylinePacker>> packers; // nullptr - страница одного большого блока
+
+    for (size_t index : order) {
+        Block& block = blocks_[index];
+        int width = block.width + options_.padding;
+        int height = block.height + options_.padding;
+
+        if (width > options_.maxSize || height > options_.maxSize) {
+            block.page = static_cast<int>(pages.size());
+            Page page;
+            page.width = block.width;
+            page.height = block.height;
+            page.blocks.push_back(index);
+            pages.push_back(page);
+            packers.push_back(nullptr);
+            continue;
+        }
+
+        for (size_t p = 0; p <= packers.size(); p++) {
+            if (p == packers.size()) {
+                packers.push_back(std::make_unique<SkylinePacker>(options_.maxSize, options_.maxSize));
+                pages.emplace_back();
+            }
+            if (packers[p] && packers[p]->insert(width, height, block.x, block.y)) {
+                block.page = static_cast<int>(p);
+                pages[p].blocks.push_back(index);
+                break;
+            }
+        }
+    }
+
+    // Страница обрезается по занятой области; зазор справа и снизу не нужен
+    for (size_t p = 0; p < pages.size(); p++) {
+        if (packers[p]) {
+            pages[p].width = std::max(packers[p]->getUsedWidth() - options_.padding, 1);
+            pages[p].height = std::max(packers[p]->getUsedHeight() - options_.padding, 1);
+        }
+    }
+    return pages;
+}
+
+bool AtlasBuilder::writeIndex(const std::vector<Page>& pages) const {
+    std::string path = options_.outputDir + "/" + options_.name + ".json";
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        return false;
+    }
+
+    out << "{\n  \"pages\": [";
+    for (size_t p = 0; p < pages.size(); p++) {
+        out << (p > 0 ? "," : "") << "\n    {\"file\": \"" << jsonEscape(getPageName(p))
+            << "\", \"width\": " << pages[p].width << ", \"height\": " << pages[p].height << "}";
+    }
+    out << "\n  ],\n  \"blocks\": [";
+
+    bool first = true;
+    for (const Block& block : blocks_) {
+        if (!block.ok) {
+            continue;
+        }
+        out << (first ? "" : ",") << "\n    {\"name\": \"" << jsonEscape(block.name)
+            << "\", \"source\": \"" << jsonEscape(block.relativePath)
+            << "\", \"page\": " << block.page
+            << ", \"x\": " << block.x << ", \"y\": " << block.y
+            << ", \"width\": " << block.width << ", \"height\": " << block.height << "}";
+        first = false;
+    }
+    out << "\n  ]\n}\n";
+
+    if (out) {
+        std::cout << "Created atlas index: " << path << std::endl;
+    }
+    return static_cast<bool>(out);
+}
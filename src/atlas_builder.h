@@ -0,0 +1,69 @@
+#ifndef ATLAS_BUILDER_H
+#define ATLAS_BUILDER_H
+
+#include "fb_layout.h"
+#include "image_generator.h"
+#include "png_encoder.h"
+#include <string>
+#include <vector>
+
+// Настройки атласа
+struct AtlasOptions {
+    std::string outputDir = "xml_png";
+    std::string name = "atlas"; // Страницы name_N.png и индекс name.json
+    int maxSize = 2048;         // Наибольшая сторона страницы в пикселях
+    int padding = 1;            // Зазор между изображениями блоков
+    int margin = 0;             // Поля вокруг каждой диаграммы
+    int jobs = 1;
+    PngOptions png;
+};
+
+// Итоги сборки атласа
+struct AtlasSummary {
+    int blockCount = 0;
+    int errorCount = 0;
+    int pageCount = 0;
+    GlyphCacheStats glyphStats;
+    RenderTimings timings;
+};
+
+// Сборка атласа: все блоки размечаются с плотными границами, упаковываются
+// в одну или несколько страниц (SkylinePacker) и растеризуются прямо в буфер
+// страницы. Каждая страница кодируется в PNG один раз. Индекс name.json
+// содержит для каждого блока имя, исходный файл, номер страницы и прямоугольник.
+class AtlasBuilder {
+public:
+    explicit AtlasBuilder(const AtlasOptions& options);
+
+    void add(const std::string& file, const std::string& relativePath);
+    AtlasSummary build();
+
+private:
+    struct Block {
+        std::string file;
+        std::string relativePath;
+        std::string name;
+        DisplayList list;
+        int width = 0;
+        int height = 0;
+        int page = -1;
+        int x = 0;
+        int y = 0;
+        bool ok = false;
+    };
+
+    struct Page {
+        int width = 0;
+        int height = 0;
+        std::vector<size_t> blocks;
+    };
+
+    AtlasOptions options_;
+    std::vector<Block> blocks_;
+
+    std::vector<Page> pack();
+    bool writeIndex(const std::vector<Page>& pages) const;
+    std::string getPageName(size_t page) const;
+};
+
+#endif
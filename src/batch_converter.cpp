@@ -0,0 +1,691 @@
+#include "batch_converter.h"
+#include "thread_pool.h"
+#include "utils.h"
+#include <exception>
+#include <filesystem>
+#include <iostream>
+
+BatchConverter::BatchConverter(const ConverterOptions& options)
+    : options_(options), nextToPrint_(0) {
+    if (options_.jobs < 1) {
+        options_.jobs = 1;
+    }
+}
+
+BatchConverter::~BatchConverter() = default;
+
+std::unique_ptr<BatchConverter::Worker> BatchConverter::createWorker() const {
+    auto worker = std::make_unique<Worker>();
+    worker->generator.setPngOptions(options_.png);
+    worker->generator.setMargin(options_.margin);
+    worker->generator.setOutputFormat(options_.format);
+    worker->generator.setOutputWriter(writer_.get());
+    return worker;
+}
+
+// Выходной путь повторяет путь входного файла относительно корня обхода
+std::string BatchConverter::getOutputName(const std::string& relativePath) const {
+    std::filesystem::path path(relativePath);
+    path.replace_extension(options_.format == OutputFormat::Svg ? ".svg" : ".png");
+    return path.generic_string();
+}
+
+// Выходные файлы всех масштабов: NAME.png, NAME@2x.png, ...
+// Для SVG масштаб не имеет смысла, файл один
+std::vector<std::string> BatchConverter::getScaledOutputNames(const std::string& outputName) const {
+    if (options_.format == OutputFormat::Svg) {
+        return {outputName};
+    }
+    std::vector<std::string> names;
+    for (int scale : options_.scales) {
+        if (scale == 1) {
+            names.push_back(outputName);
+            continue;
+        }
+        std::filesystem::path path(outputName);
+        std::string extension = path.extension().string();
+        path.replace_extension();
+        names.push_back(path.generic_string() + "@" + std::to_string(scale) + "x" + extension);
+    }
+    return names;
+}
+
+// Сеть составного блока пишется рядом с интерфейсом: NAME_network.png
+std::string BatchConverter::getNetworkOutputName(const std::string& outputName) const {
+    std::filesystem::path path(outputName);
+    std::string extension = path.extension().string();
+    path.replace_extension();
+    return path.generic_string() + "_network" + extension;
+}
+
+// Изображения сети всех масштабов
+std::vector<std::string> BatchConverter::getNetworkOutputNames(const std::string& outputName) const {
+    return getScaledOutputNames(getNetworkOutputName(outputName));
+}
+
+// Все файлы, которые могут быть созданы для входного файла (для удаления)
+std::vector<std::string> BatchConverter::getAllOutputNames(const std::string& outputName) const {
+    std::vector<std::string> names = getScaledOutputNames(outputName);
+    for (const auto& name : getNetworkOutputNames(outputName)) {
+        names.push_back(name);
+    }
+    return names;
+}
+
+// Набор масштабов входит в отпечаток: при его смене все файлы перерисовываются
+std::string BatchConverter::getFingerprint(const Worker& worker) const {
+    std::string fingerprint = worker.generator.getFingerprint();
+    if (options_.format == OutputFormat::Png && options_.scales != std::vector<int>{1}) {
+        fingerprint += ";scales=";
+        for (size_t i = 0; i < options_.scales.size(); i++) {
+            fingerprint += (i > 0 ? "," : "") + std::to_string(options_.scales[i]);
+        }
+    }
+    return fingerprint;
+}
+
+std::string BatchConverter::getManifestPath() const {
+    return options_.outputDir + "/" + BuildManifest::FILE_NAME;
+}
+
+std::string BatchConverter::getCachePath() const {
+    return options_.outputDir + "/" + InterfaceCache::FILE_NAME;
+}
+
+void BatchConverter::begin() {
+    summary_ = ConversionSummary();
+    manifest_ = BuildManifest();
+    currentOutputs_.clear();
+    logs_.clear();
+    finished_.clear();
+    nextToPrint_ = 0;
+    deferred_.clear();
+    discovering_ = options_.types != nullptr;
+    
+    if (options_.asyncWrite) {
+        writer_ = std::make_unique<OutputWriter>();
+        if (primaryWorker_) {
+            primaryWorker_->generator.setOutputWriter(writer_.get());
+        }
+    }
+    
+    if (options_.interfaceCache) {
+        cache_.load(getCachePath());
+        // Типы из сетей составных блоков тоже берутся из кэша
+        if (options_.types) {
+            options_.types->setCache(&cache_);
+        }
+    }
+    
+    if (options_.incremental) {
+        // Отпечаток зависит от загруженного шрифта, поэтому генератор первого
+        // потока создается заранее
+        if (!primaryWorker_) {
+            primaryWorker_ = createWorker();
+        }
+        std::string fingerprint = getFingerprint(*primaryWorker_);
+        
+        manifest_.load(getManifestPath());
+        if (manifest_.getFingerprint() != fingerprint) {
+            if (!manifest_.getFingerprint().empty()) {
+                std::cout << "Renderer configuration changed, rebuilding all files" << std::endl;
+            }
+            manifest_.clear();
+            manifest_.setFingerprint(fingerprint);
+        }
+    }
+    
+    if (options_.jobs > 1) {
+        pool_ = std::make_unique<ThreadPool>(static_cast<size_t>(options_.jobs));
+        // Рабочие ресурсы создаются лениво внутри своего потока,
+        // чтобы инициализация FreeType тоже шла параллельно
+        workers_.clear();
+        workers_.resize(pool_->size());
+        workers_[0] = std::move(primaryWorker_);
+    }
+}
+
+void BatchConverter::submit(const std::string& file, const std::string& relativePath) {
+    enqueue(file, getOutputName(relativePath));
+}
+
+void BatchConverter::enqueue(const std::string& file, const std::string& outputName) {
+    if (!pool_) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            currentOutputs_.insert(outputName);
+        }
+        if (!primaryWorker_) {
+            primaryWorker_ = createWorker();
+        }
+        // Журнал отложенного файла не выводится: файл будет обработан заново
+        std::string log;
+        bool done;
+        {
+            utils::ScopedLogCapture capture;
+            done = processFile(file, outputName, *primaryWorker_);
+            log = capture.str();
+        }
+        if (done) {
+            std::cout << log << std::flush;
+        }
+        return;
+    }
+    
+    // Журналы хранятся по порядковому номеру файла, поэтому порядок вывода
+    // не зависит от порядка завершения задач
+    size_t index;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        currentOutputs_.insert(outputName);
+        index = logs_.size();
+        logs_.emplace_back();
+        finished_.push_back(0);
+    }
+    
+    pool_->submit([this, file, outputName, index](size_t workerIndex) {
+        std::unique_ptr<Worker>& worker = workers_[workerIndex];
+        std::string log;
+        {
+            utils::ScopedLogCapture capture;
+            // Исключение (нехватка памяти на огромный холст, сбой FreeType) не должно
+            // оставить файл без учета и остановить вывод журналов следующих файлов
+            bool done = true;
+            try {
+                if (!worker) {
+                    worker = createWorker();
+                }
+                done = processFile(file, outputName, *worker);
+            } catch (const std::exception& e) {
+                utils::logErr() << "[ERROR] Failed to convert " << file << ": " << e.what() << std::endl;
+                std::lock_guard<std::mutex> lock(mutex_);
+                summary_.errorCount++;
+                manifest_.remove(outputName);
+            }
+            if (done) {
+                log = capture.str();
+            }
+        }
+        printFinishedLogs(index, std::move(log));
+    });
+}
+
+// Сеть составного блока рисуется, когда индекс типов полон: пока идет обход,
+// файл откладывается до finish()
+bool BatchConverter::deferFile(const std::string& file, const std::string& outputName) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!discovering_) {
+        return false;
+    }
+    deferred_.emplace_back(file, outputName);
+    return true;
+}
+
+// Печатаем все готовые файлы подряд, начиная с первого ненапечатанного
+void BatchConverter::printFinishedLogs(size_t index, std::string log) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    logs_[index] = std::move(log);
+    finished_[index] = 1;
+    while (nextToPrint_ < logs_.size() && finished_[nextToPrint_]) {
+        std::cout << logs_[nextToPrint_] << std::flush;
+        logs_[nextToPrint_].clear();
+        nextToPrint_++;
+    }
+}
+
+// Проверка по манифесту и преобразование одного файла; итоги - в summary_.
+// false - файл отложен до конца обхода (deferFile) и будет обработан заново
+bool BatchConverter::processFile(const std::string& file, const std::string& outputName, Worker& worker) {
+    uint64_t hash = 0;
+    bool hashed = false;
+    
+    // Хеш считается в рабочем потоке; нечитаемый файл обрабатывается как
+    // обычно, чтобы ошибка попала в итоги
+    if (options_.incremental || options_.interfaceCache) {
+        hashed = utils::hashFile(file, hash);
+    }
+    
+    if (options_.incremental) {
+        if (hashed) {
+            bool upToDate = false;
+            bool hasNetwork = false;
+            std::vector<ManifestDependency> dependencies;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                const ManifestEntry* entry = manifest_.find(outputName);
+                upToDate = entry && entry->contentHash == hash && entry->inputPath == file;
+                hasNetwork = upToDate && entry->hasNetwork;
+                if (upToDate) {
+                    dependencies = entry->dependencies;
+                }
+            }
+            if (upToDate && !dependencies.empty() && deferFile(file, outputName)) {
+                return false;
+            }
+            // Сеть устарела и при неизменном файле, если изменился интерфейс типа ее экземпляров
+            upToDate = upToDate && dependenciesUpToDate(dependencies);
+            if (upToDate) {
+                for (const auto& name : hasNetwork ? getAllOutputNames(outputName) : getScaledOutputNames(outputName)) {
+                    upToDate = upToDate && utils::fileExists(options_.outputDir + "/" + name);
+                }
+            }
+            if (upToDate) {
+                if (options_.interfaceCache) {
+                    cache_.retain(hash);
+                }
+                addDependents(file, outputName, dependencies);
+                std::lock_guard<std::mutex> lock(mutex_);
+                summary_.skippedCount++;
+                return true;
+            }
+        }
+    }
+    
+    const FbInterface* fb = loadFile(file, worker, hashed ? &hash : nullptr);
+    if (fb && !fb->network.empty() && deferFile(file, outputName)) {
+        return false;
+    }
+    ManifestEntry entry;
+    bool ok = fb && renderFile(file, outputName, worker, *fb, &entry);
+    
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (ok) {
+        summary_.successCount++;
+    } else {
+        summary_.errorCount++;
+    }
+    
+    if (options_.incremental) {
+        // Неудачные файлы убираем из манифеста, чтобы повторить их в следующий раз
+        if (ok && hashed) {
+            entry.contentHash = hash;
+            entry.inputPath = file;
+            manifest_.set(outputName, entry);
+        } else {
+            manifest_.remove(outputName);
+        }
+    }
+    return true;
+}
+
+ConversionSummary BatchConverter::finish() {
+    if (pool_) {
+        pool_->wait();
+    }
+    
+    // Обход закончен, индекс типов полон: отложенные составные блоки получают
+    // новые номера журналов и выводятся после остальных файлов
+    std::vector<std::pair<std::string, std::string>> deferred;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        discovering_ = false;
+        deferred.swap(deferred_);
+    }
+    for (const auto& file : deferred) {
+        enqueue(file.first, file.second);
+    }
+    
+    if (pool_) {
+        pool_->wait();
+        pool_.reset();
+        for (const auto& worker : workers_) {
+            if (worker) {
+                addWorkerStats(summary_, *worker);
+            }
+        }
+        // Генератор первого потока остается прогретым для updateFile
+        primaryWorker_ = std::move(workers_[0]);
+        workers_.clear();
+    } else if (primaryWorker_) {
+        addWorkerStats(summary_, *primaryWorker_);
+    }
+    
+    flushOutputs();
+    
+    // Без единого входного файла (неверная директория) выходные файлы не трогаем
+    if (options_.incremental && !currentOutputs_.empty()) {
+        // Удаляем PNG, входные файлы которых исчезли
+        std::vector<std::string> orphans;
+        for (const auto& entry : manifest_.getEntries()) {
+            if (currentOutputs_.count(entry.first) == 0) {
+                orphans.push_back(entry.first);
+            }
+        }
+        for (const auto& orphan : orphans) {
+            for (const auto& name : getAllOutputNames(orphan)) {
+                std::error_code ec;
+                if (std::filesystem::remove(options_.outputDir + "/" + name, ec)) {
+                    std::cout << "Removed orphaned output: " << name << std::endl;
+                    summary_.removedCount++;
+                }
+            }
+            manifest_.remove(orphan);
+        }
+        
+        manifest_.save(getManifestPath());
+    }
+    
+    // Без входных файлов кэш не перезаписывается, иначе он оказался бы пустым
+    if (options_.interfaceCache && !currentOutputs_.empty()) {
+        cache_.save(getCachePath());
+    }
+    
+    if (options_.types) {
+        summary_.typeStats = options_.types->getStats();
+    }
+    summary_.cacheStats = cache_.getStats();
+    return summary_;
+}
+
+// Дожидаемся записи всех файлов. Файл, который не удалось записать, переводит
+// свой входной файл из успешных в ошибки, и тот не попадает в манифест.
+// Режим наблюдения дальше пишет файлы сам
+void BatchConverter::flushOutputs() {
+    if (!writer_) {
+        return;
+    }
+    std::vector<std::string> failed = writer_->flush();
+    summary_.writerStats = writer_->getStats();
+    writer_.reset();
+    if (primaryWorker_) {
+        primaryWorker_->generator.setOutputWriter(nullptr);
+    }
+    if (failed.empty()) {
+        return;
+    }
+    
+    std::set<std::string> failedFiles(failed.begin(), failed.end());
+    for (const auto& path : failed) {
+        std::cerr << "[ERROR] Failed to write: " << path << std::endl;
+    }
+    for (const auto& outputName : currentOutputs_) {
+        for (const auto& name : getAllOutputNames(outputName)) {
+            if (failedFiles.count(options_.outputDir + "/" + name) > 0) {
+                summary_.successCount--;
+                summary_.errorCount++;
+                manifest_.remove(outputName);
+                break;
+            }
+        }
+    }
+}
+
+ConversionSummary BatchConverter::run(const std::vector<std::string>& files) {
+    begin();
+    for (const auto& file : files) {
+        submit(file, std::filesystem::path(file).filename().string());
+    }
+    return finish();
+}
+
+bool BatchConverter::updateFile(const std::string& file, const std::string& relativePath) {
+    // Сети берут интерфейсы типов из индекса, поэтому он обновляется до перерисовки
+    if (options_.types) {
+        options_.types->update(file);
+    }
+    
+    bool ok = true;
+    if (!utils::fileExists(file)) {
+        for (const auto& name : getAllOutputNames(getOutputName(relativePath))) {
+            std::string outputFile = options_.outputDir + "/" + name;
+            std::error_code ec;
+            if (std::filesystem::remove(outputFile, ec)) {
+                std::cout << "Removed output of deleted file: " << outputFile << std::endl;
+            }
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& dependent : dependents_) {
+            dependent.second.erase(file);
+        }
+    } else {
+        if (!primaryWorker_) {
+            primaryWorker_ = createWorker();
+        }
+        ok = convertFile(file, getOutputName(relativePath), *primaryWorker_);
+    }
+    
+    // Составные блоки с экземплярами этого типа: их сети отрисованы со старым интерфейсом
+    std::map<std::string, std::string> dependents;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = dependents_.find(utils::getFileNameWithoutExtension(file));
+        if (it != dependents_.end()) {
+            dependents = it->second;
+        }
+    }
+    for (const auto& dependent : dependents) {
+        if (dependent.first == file) {
+            continue;
+        }
+        if (!primaryWorker_) {
+            primaryWorker_ = createWorker();
+        }
+        ok = convertFile(dependent.first, dependent.second, *primaryWorker_) && ok;
+    }
+    return ok;
+}
+
+void BatchConverter::removeDirectory(const std::string& relativePath) {
+    namespace fs = std::filesystem;
+    fs::path outputPath = fs::path(options_.outputDir) / relativePath;
+    std::string extension = options_.format == OutputFormat::Svg ? ".svg" : ".png";
+    
+    std::error_code ec;
+    if (relativePath.empty() || relativePath.compare(0, 2, "..") == 0 || !fs::is_directory(outputPath, ec)) {
+        return;
+    }
+    std::vector<fs::path> files;
+    std::vector<fs::path> directories = {outputPath};
+    for (fs::recursive_directory_iterator it(outputPath, ec), end; !ec && it != end; it.increment(ec)) {
+        std::error_code statError;
+        if (it->is_directory(statError)) {
+            directories.push_back(it->path());
+        } else if (it->is_regular_file(statError) && it->path().extension() == extension) {
+            files.push_back(it->path());
+        }
+    }
+    
+    for (const auto& file : files) {
+        if (fs::remove(file, ec)) {
+            std::cout << "Removed output of moved directory: " << file.generic_string() << std::endl;
+        }
+    }
+    // Опустевшие директории - начиная с самых вложенных; непустые остаются
+    for (auto it = directories.rbegin(); it != directories.rend(); ++it) {
+        fs::remove(*it, ec);
+    }
+}
+
+// Интерфейс файла: из кэша по хешу содержимого, иначе разбором XML
+const FbInterface* BatchConverter::loadInterface(const std::string& file, Worker& worker, const uint64_t* contentHash) {
+    uint64_t hash = 0;
+    bool hashed = false;
+    if (options_.interfaceCache && contentHash) {
+        hash = *contentHash;
+        hashed = true;
+    } else if (options_.interfaceCache) {
+        hashed = utils::hashFile(file, hash);
+    }
+    
+    if (hashed && cache_.find(hash, worker.cachedInterface)) {
+        return &worker.cachedInterface;
+    }
+    
+    if (!worker.parser.parseFile(file)) {
+        return nullptr;
+    }
+    if (hashed) {
+        cache_.store(hash, worker.parser.getInterface());
+    }
+    return &worker.parser.getInterface();
+}
+
+// Преобразование одного файла: парсинг, отрисовка, запись PNG
+bool BatchConverter::convertFile(const std::string& file, const std::string& outputName, Worker& worker) {
+    const FbInterface* fb = loadFile(file, worker, nullptr);
+    return fb && renderFile(file, outputName, worker, *fb);
+}
+
+const FbInterface* BatchConverter::loadFile(const std::string& file, Worker& worker, const uint64_t* contentHash) {
+    utils::logOut() << "\nProcessing: " << file << std::endl;
+    
+    if (!utils::fileExists(file)) {
+        utils::logErr() << "File does not exist: " << file << std::endl;
+        return nullptr;
+    }
+    
+    const FbInterface* fb = loadInterface(file, worker, contentHash);
+    if (!fb) {
+        utils::logErr() << "[ERROR] Failed to parse: " << file << std::endl;
+    }
+    return fb;
+}
+
+// Отрисовка разобранного файла и его сети
+bool BatchConverter::renderFile(const std::string& file, const std::string& outputName, Worker& worker,
+                                const FbInterface& fb, ManifestEntry* manifestEntry) {
+    std::filesystem::path outputPath = std::filesystem::path(options_.outputDir) / outputName;
+    std::string outputFile = options_.outputDir + "/" + outputName;
+    
+    // Поддиректория, повторяющая структуру входного дерева
+    if (outputPath.has_parent_path()) {
+        std::error_code ec;
+        std::filesystem::create_directories(outputPath.parent_path(), ec);
+    }
+    
+    bool hasNetwork = !fb.network.empty();
+    if (manifestEntry) {
+        manifestEntry->hasNetwork = hasNetwork;
+    }
+    if (!hasNetwork) {
+        // Сеть могла быть удалена из файла: старое изображение больше не соответствует ему
+        for (const auto& name : getNetworkOutputNames(outputName)) {
+            std::error_code ec;
+            if (std::filesystem::remove(options_.outputDir + "/" + name, ec)) {
+                utils::logOut() << "Removed stale network image: " << name << std::endl;
+            }
+        }
+    }
+    
+    bool ok = true;
+    std::vector<std::string> outputNames = getScaledOutputNames(outputName);
+    if (outputNames.size() == 1 && outputNames[0] == outputName) {
+        if (!worker.generator.generateImage(fb, outputFile)) {
+            utils::logErr() << "[ERROR] Failed to create image for: " << file << std::endl;
+            return false;
+        }
+        utils::logOut() << "[OK] Created: " << outputFile << std::endl;
+    } else {
+        // Одна разметка на все масштабы; растеризация и кодирование - для каждого свои
+        DisplayList list = worker.generator.layoutDiagram(fb);
+        for (size_t i = 0; i < outputNames.size(); i++) {
+            std::string scaledFile = options_.outputDir + "/" + outputNames[i];
+            worker.generator.setScale(options_.scales[i]);
+            if (worker.generator.renderDisplayList(list, scaledFile)) {
+                utils::logOut() << "[OK] Created: " << scaledFile << std::endl;
+            } else {
+                utils::logErr() << "[ERROR] Failed to create image for: " << file << " at scale " << options_.scales[i] << std::endl;
+                ok = false;
+            }
+        }
+        worker.generator.setScale(1);
+    }
+    
+    if (hasNetwork) {
+        ok = convertNetwork(file, outputName, worker, fb) && ok;
+        // Зависимости сети: файлы и хеши типов ее экземпляров
+        std::vector<ManifestDependency> dependencies = getDependencies(fb);
+        addDependents(file, outputName, dependencies);
+        if (manifestEntry) {
+            manifestEntry->dependencies = std::move(dependencies);
+        }
+    }
+    return ok;
+}
+
+// Сеть составного блока: изображение может быть намного больше интерфейса,
+// поэтому PNG растеризуется полосами и сразу сжимается в файл
+bool BatchConverter::convertNetwork(const std::string& file, const std::string& outputName, Worker& worker,
+                                    const FbInterface& fb) {
+    DisplayList list = worker.generator.layoutNetwork(fb, options_.types.get());
+    std::vector<std::string> outputNames = getNetworkOutputNames(outputName);
+    
+    bool ok = true;
+    for (size_t i = 0; i < outputNames.size(); i++) {
+        std::string networkFile = options_.outputDir + "/" + outputNames[i];
+        bool created = false;
+        if (options_.format == OutputFormat::Svg) {
+            created = worker.generator.writeSvg(list, networkFile);
+        } else {
+            worker.generator.setScale(options_.scales[i]);
+            created = worker.generator.renderBanded(list, networkFile);
+        }
+        if (created) {
+            utils::logOut() << "[OK] Created: " << networkFile << std::endl;
+        } else {
+            utils::logErr() << "[ERROR] Failed to create network image for: " << file << std::endl;
+            ok = false;
+        }
+    }
+    worker.generator.setScale(1);
+    return ok;
+}
+
+// Типы экземпляров сети и файлы, из которых взяты их интерфейсы
+std::vector<ManifestDependency> BatchConverter::getDependencies(const FbInterface& fb) const {
+    std::set<std::string> typeNames;
+    for (const auto& instance : fb.network.instances) {
+        if (!instance.type.empty()) {
+            typeNames.insert(instance.type);
+        }
+    }
+    
+    std::vector<ManifestDependency> dependencies;
+    for (const auto& typeName : typeNames) {
+        ManifestDependency dependency;
+        dependency.typeName = typeName;
+        if (options_.types) {
+            options_.types->locate(typeName, dependency.path, dependency.contentHash);
+        }
+        dependencies.push_back(dependency);
+    }
+    return dependencies;
+}
+
+// Каждый тип по-прежнему берется из того же файла с тем же содержимым (или так же не найден)
+bool BatchConverter::dependenciesUpToDate(const std::vector<ManifestDependency>& dependencies) const {
+    for (const auto& dependency : dependencies) {
+        std::string path;
+        uint64_t contentHash = 0;
+        if (!options_.types || !options_.types->locate(dependency.typeName, path, contentHash)) {
+            if (!dependency.path.empty()) {
+                return false;
+            }
+        } else if (path != dependency.path || contentHash != dependency.contentHash) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void BatchConverter::addDependents(const std::string& file, const std::string& outputName,
+                                   const std::vector<ManifestDependency>& dependencies) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& dependency : dependencies) {
+        size_t separator = dependency.typeName.rfind("::");
+        std::string name = separator == std::string::npos ? dependency.typeName : dependency.typeName.substr(separator + 2);
+        dependents_[name][file] = outputName;
+    }
+}
+
+void BatchConverter::addWorkerStats(ConversionSummary& summary, const Worker& worker) {
+    GlyphCacheStats stats = worker.generator.getGlyphCacheStats();
+    summary.glyphStats.hits += stats.hits;
+    summary.glyphStats.misses += stats.misses;
+    summary.glyphStats.entries += stats.entries;
+    
+    RenderTimings timings = worker.generator.getTimings();
+    summary.timings.layoutMs += timings.layoutMs;
+    summary.timings.rasterMs += timings.rasterMs;
+    summary.timings.encodeMs += timings.encodeMs;
+}
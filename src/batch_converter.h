@@ -0,0 +1,147 @@
+#ifndef BATCH_CONVERTER_H
+#define BATCH_CONVERTER_H
+
+#include "xml_parser.h"
+#include "image_generator.h"
+#include "build_manifest.h"
+#include "interface_cache.h"
+#include "output_writer.h"
+#include "type_index.h"
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class ThreadPool;
+
+// Настройки пакетного преобразования
+struct ConverterOptions {
+    std::string outputDir = "xml_png";
+    int jobs = 1;             // Число рабочих потоков
+    bool incremental = false; // Пропускать файлы, не изменившиеся с прошлого запуска
+    bool interfaceCache = true; // Брать разобранные интерфейсы из кэша в outputDir вместо XML
+    bool asyncWrite = true;   // Писать файлы отдельным потоком (OutputWriter)
+    PngOptions png;           // Палитра, уровень сжатия и фильтрация PNG
+    int margin = 10;          // Поля вокруг диаграммы в пикселях
+    OutputFormat format = OutputFormat::Png;
+    std::vector<int> scales = {1}; // Масштабы PNG; масштаб N > 1 пишется в NAME@Nx.png
+    std::shared_ptr<TypeIndex> types; // Интерфейсы типов для сетей составных блоков; может быть пуст
+};
+
+// Итоги пакетного преобразования
+struct ConversionSummary {
+    int successCount = 0;
+    int errorCount = 0;
+    int skippedCount = 0;  // Файлы, пропущенные инкрементальной сборкой
+    int removedCount = 0;  // Удаленные устаревшие PNG
+    GlyphCacheStats glyphStats; // Суммарная статистика кэшей глифов всех потоков
+    RenderTimings timings;      // Суммарное время стадий отрисовки всех потоков
+    TypeIndexStats typeStats;   // Обращения к индексу типов за все время работы
+    InterfaceCacheStats cacheStats; // Обращения к кэшу интерфейсов за все время работы
+    OutputWriterStats writerStats;  // Асинхронная запись последнего запуска
+};
+
+// Пакетное преобразование .fbt файлов в PNG.
+// Файлы подаются потоком: begin(), затем submit() для каждого файла по мере
+// его обнаружения, затем finish(). Выходной файл кладется в outputDir по пути
+// входного файла относительно корня обхода, повторяя структуру директорий.
+// При jobs > 1 файлы распределяются по пулу потоков; у каждого потока свой
+// XmlParser и свой ImageGenerator (FT_Library/FT_Face не потокобезопасны).
+// Журнал каждого файла собирается в буфер и выводится целиком в порядке подачи.
+// В инкрементальном режиме в выходной директории ведется манифест с хешами входных
+// файлов, и неизменившиеся файлы не парсятся и не отрисовываются.
+// Для составных блоков в нем же хранятся файлы и хеши типов экземпляров сети:
+// изменение интерфейса типа делает сеть устаревшей.
+// При нескольких масштабах файл разбирается и размечается один раз, а
+// растеризуется и кодируется отдельно для каждого масштаба.
+// Разобранные интерфейсы сохраняются в кэше в выходной директории (InterfaceCache):
+// файл с уже встречавшимся содержимым не разбирается повторно.
+// Готовые файлы пишет на диск отдельный поток (OutputWriter), так что разбор,
+// отрисовка и кодирование не ждут диска; ошибки записи учитываются в finish().
+class BatchConverter {
+public:
+    explicit BatchConverter(const ConverterOptions& options);
+    ~BatchConverter();
+
+    void begin();
+    // Можно вызывать из любого потока между begin() и finish(). Индекс типов
+    // (options.types) может пополняться до finish(): составные блоки, которым он
+    // нужен для сети, откладываются и отрисовываются в finish()
+    void submit(const std::string& file, const std::string& relativePath);
+    ConversionSummary finish();
+
+    // Готовый список: begin, submit каждого файла под его именем, finish
+    ConversionSummary run(const std::vector<std::string>& files);
+    
+    // Обновление одного файла для режима наблюдения: существующий файл
+    // перерисовывается прогретым генератором, для исчезнувшего удаляется выходной файл.
+    // Если файл - тип из сетей уже отрисованных составных блоков, перерисовываются и они.
+    // Манифест инкрементальной сборки не меняется - следующий запуск сверит хеши сам.
+    bool updateFile(const std::string& file, const std::string& relativePath);
+    // Входная директория ушла из дерева целиком: удаляются выходные файлы в ее
+    // отражении в outputDir (какие входные файлы в ней были, уже не узнать)
+    void removeDirectory(const std::string& relativePath);
+
+private:
+    // Ресурсы одного рабочего потока
+    struct Worker {
+        XmlParser parser;
+        ImageGenerator generator;
+        FbInterface cachedInterface; // Интерфейс текущего файла, если он взят из кэша
+    };
+
+    ConverterOptions options_;
+    std::unique_ptr<Worker> primaryWorker_; // Сохраняется между запусками (режим наблюдения)
+    std::unique_ptr<ThreadPool> pool_;
+    std::vector<std::unique_ptr<Worker>> workers_; // По одному на поток пула, создаются лениво
+
+    // Состояние текущего запуска; защищено mutex_
+    std::mutex mutex_;
+    ConversionSummary summary_;
+    BuildManifest manifest_;
+    InterfaceCache cache_;
+    std::unique_ptr<OutputWriter> writer_; // Существует между begin() и finish()
+    std::set<std::string> currentOutputs_; // Выходные файлы, которые должны существовать после запуска
+    std::vector<std::string> logs_;
+    std::vector<char> finished_;
+    size_t nextToPrint_;
+
+    // Составные блоки по типам их экземпляров (имя типа без пакета -> входной
+    // файл -> выходное имя); сохраняется между запусками для режима наблюдения. Защищено mutex_
+    std::unordered_map<std::string, std::map<std::string, std::string>> dependents_;
+    bool discovering_ = false; // Между begin() и finish(): индекс типов еще пополняется
+    std::vector<std::pair<std::string, std::string>> deferred_; // Отложенные файлы: входной файл, выходное имя
+
+    std::unique_ptr<Worker> createWorker() const;
+    std::string getOutputName(const std::string& relativePath) const;
+    std::vector<std::string> getScaledOutputNames(const std::string& outputName) const;
+    std::string getNetworkOutputName(const std::string& outputName) const;
+    std::vector<std::string> getAllOutputNames(const std::string& outputName) const;
+    std::vector<std::string> getNetworkOutputNames(const std::string& outputName) const;
+    std::string getFingerprint(const Worker& worker) const;
+    std::string getManifestPath() const;
+    std::string getCachePath() const;
+    void enqueue(const std::string& file, const std::string& outputName);
+    bool processFile(const std::string& file, const std::string& outputName, Worker& worker);
+    bool deferFile(const std::string& file, const std::string& outputName);
+    const FbInterface* loadInterface(const std::string& file, Worker& worker, const uint64_t* contentHash);
+    const FbInterface* loadFile(const std::string& file, Worker& worker, const uint64_t* contentHash);
+    bool convertFile(const std::string& file, const std::string& outputName, Worker& worker);
+    bool renderFile(const std::string& file, const std::string& outputName, Worker& worker,
+                    const FbInterface& fb, ManifestEntry* manifestEntry = nullptr);
+    bool convertNetwork(const std::string& file, const std::string& outputName, Worker& worker,
+                        const FbInterface& fb);
+    std::vector<ManifestDependency> getDependencies(const FbInterface& fb) const;
+    bool dependenciesUpToDate(const std::vector<ManifestDependency>& dependencies) const;
+    void addDependents(const std::string& file, const std::string& outputName,
+                       const std::vector<ManifestDependency>& dependencies);
+    void printFinishedLogs(size_t index, std::string log);
+    void flushOutputs();
+    static void addWorkerStats(ConversionSummary& summary, const Worker& worker);
+};
+
+#endif
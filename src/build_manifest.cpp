@@ -0,0 +1,131 @@
+#include "build_manifest.h"
+#include "utils.h"
+#include <filesystem>
+#include <fstream>
+
+// Формат (текстовый, по строке на запись):
+//   FBT_MANIFEST 3
+//   fingerprint <строка>
+//   <хеш hex>\t<признаки>\t<выходной файл>\t<входной файл>
+//   +\t<хеш hex>\t<тип>\t<файл типа>    - зависимости предыдущей записи
+// Признаки: "n" - у файла есть сеть, "-" - нет
+static const char* MANIFEST_MAGIC = "FBT_MANIFEST 3";
+
+const char* BuildManifest::FILE_NAME = ".fbt_to_png.manifest";
+
+bool BuildManifest::load(const std::string& path) {
+    clear();
+
+    std::ifstream in(path);
+    if (!in) {
+        return false;
+    }
+
+    std::string line;
+    if (!std::getline(in, line) || line != MANIFEST_MAGIC) {
+        utils::logErr() << "WARNING: Ignoring manifest with unknown format: " << path << std::endl;
+        return false;
+    }
+
+    const std::string fingerprintPrefix = "fingerprint ";
+    if (!std::getline(in, line) || line.compare(0, fingerprintPrefix.size(), fingerprintPrefix) != 0) {
+        utils::logErr() << "WARNING: Ignoring manifest without fingerprint: " << path << std::endl;
+        return false;
+    }
+    fingerprint_ = line.substr(fingerprintPrefix.size());
+
+    ManifestEntry* last = nullptr;
+    while (std::getline(in, line)) {
+        size_t firstTab = line.find('\t');
+        size_t secondTab = firstTab == std::string::npos ? firstTab : line.find('\t', firstTab + 1);
+        size_t thirdTab = secondTab == std::string::npos ? secondTab : line.find('\t', secondTab + 1);
+        if (thirdTab == std::string::npos) {
+            last = nullptr;
+            continue;
+        }
+
+        if (line.compare(0, firstTab, "+") == 0) {
+            if (!last) {
+                continue;
+            }
+            ManifestDependency dependency;
+            try {
+                dependency.contentHash = std::stoull(line.substr(firstTab + 1, secondTab - firstTab - 1), nullptr, 16);
+            } catch (const std::exception&) {
+                continue;
+            }
+            dependency.typeName = line.substr(secondTab + 1, thirdTab - secondTab - 1);
+            dependency.path = line.substr(thirdTab + 1);
+            last->dependencies.push_back(dependency);
+            continue;
+        }
+
+        ManifestEntry entry;
+        try {
+            entry.contentHash = std::stoull(line.substr(0, firstTab), nullptr, 16);
+        } catch (const std::exception&) {
+            last = nullptr;
+            continue;
+        }
+        entry.hasNetwork = line.compare(firstTab + 1, secondTab - firstTab - 1, "n") == 0;
+        entry.inputPath = line.substr(thirdTab + 1);
+        last = &(entries_[line.substr(secondTab + 1, thirdTab - secondTab - 1)] = entry);
+    }
+
+    return true;
+}
+
+bool BuildManifest::save(const std::string& path) const {
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::trunc);
+        if (!out) {
+            utils::logErr() << "ERROR: Could not write manifest: " << tempPath << std::endl;
+            return false;
+        }
+
+        out << MANIFEST_MAGIC << "\n";
+        out << "fingerprint " << fingerprint_ << "\n";
+        for (const auto& entry : entries_) {
+            out << utils::formatHash(entry.second.contentHash) << '\t'
+                << (entry.second.hasNetwork ? "n" : "-") << '\t'
+                << entry.first << '\t' << entry.second.inputPath << "\n";
+            for (const auto& dependency : entry.second.dependencies) {
+                out << "+\t" << utils::formatHash(dependency.contentHash) << '\t'
+                    << dependency.typeName << '\t' << dependency.path << "\n";
+            }
+        }
+
+        if (!out) {
+            utils::logErr() << "ERROR: Could not write manifest: " << tempPath << std::endl;
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tempPath, path, ec);
+    if (ec) {
+        utils::logErr() << "ERROR: Could not replace manifest " << path << ": " << ec.message() << std::endl;
+        std::filesystem::remove(tempPath, ec);
+        return false;
+    }
+    return true;
+}
+
+const ManifestEntry* BuildManifest::find(const std::string& outputName) const {
+    auto it = entries_.find(outputName);
+    return it != entries_.end() ? &it->second : nullptr;
+}
+
+void BuildManifest::set(const std::string& outputName, const ManifestEntry& entry) {
+    entries_[outputName] = entry;
+}
+
+void BuildManifest::remove(const std::string& outputName) {
+    entries_.erase(outputName);
+}
+
+void BuildManifest::clear() {
+    fingerprint_.clear();
+    entries_.clear();
+}
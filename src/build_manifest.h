@@ -0,0 +1,52 @@
+#ifndef BUILD_MANIFEST_H
+#define BUILD_MANIFEST_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+// Тип экземпляра сети, интерфейс которого попал в изображение сети
+struct ManifestDependency {
+    std::string typeName;
+    std::string path;         // Файл типа; пусто, если тип не был найден
+    uint64_t contentHash = 0; // Хеш содержимого файла типа
+};
+
+// Запись манифеста: из какого входного файла и с каким содержимым получен выходной файл
+struct ManifestEntry {
+    uint64_t contentHash = 0;
+    std::string inputPath;
+    bool hasNetwork = false; // Кроме интерфейса записаны изображения сети (NAME_network.png)
+    std::vector<ManifestDependency> dependencies;
+};
+
+// Манифест инкрементальной сборки, хранится в выходной директории.
+// Ключ - имя выходного файла относительно выходной директории.
+// Отпечаток (fingerprint) описывает версию и настройки генератора: при его
+// изменении все файлы считаются устаревшими.
+class BuildManifest {
+public:
+    static const char* FILE_NAME;
+
+    // Загрузка манифеста; отсутствующий или поврежденный файл дает пустой манифест
+    bool load(const std::string& path);
+    // Атомарная запись через временный файл
+    bool save(const std::string& path) const;
+
+    const std::string& getFingerprint() const { return fingerprint_; }
+    void setFingerprint(const std::string& fingerprint) { fingerprint_ = fingerprint; }
+
+    const ManifestEntry* find(const std::string& outputName) const;
+    void set(const std::string& outputName, const ManifestEntry& entry);
+    void remove(const std::string& outputName);
+    void clear();
+
+    const std::map<std::string, ManifestEntry>& getEntries() const { return entries_; }
+
+private:
+    std::string fingerprint_;
+    std::map<std::string, ManifestEntry> entries_;
+};
+
+#endif
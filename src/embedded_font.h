@@ -0,0 +1,24 @@
+#ifndef EMBEDDED_FONT_H
+#define EMBEDDED_FONT_H
+
+#include "glyph_cache.h"
+#include <cstddef>
+
+// Данные, которые генерируются при сборке (см. CMakeLists.txt).
+// Определены только при FBT_RENDER_EMBEDDED_FONT и FBT_RENDER_PREBUILT_GLYPHS соответственно.
+
+// Шрифт, встроенный в библиотеку (cmake/EmbedFont.cmake)
+namespace embedded_font {
+    extern const unsigned char data[];
+    extern const size_t size;
+    extern const char name[]; // Имя исходного файла шрифта
+}
+
+// ASCII-глифы размеров, которые использует разметка диаграммы (fbt_glyph_atlas)
+namespace prebuilt_glyphs {
+    extern const PrebuiltGlyph glyphs[];
+    extern const size_t count;
+    extern const unsigned char bitmaps[];
+}
+
+#endif
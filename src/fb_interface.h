@@ -0,0 +1,66 @@
+#ifndef FB_INTERFACE_H
+#define FB_INTERFACE_H
+
+#include <string>
+#include <vector>
+
+// Событие интерфейса функционального блока
+struct FbEvent {
+    std::string name;
+    std::string type;
+    std::string comment;
+    std::vector<std::string> with; // Переменные, связанные с событием (элементы With)
+};
+
+// Переменная интерфейса функционального блока
+struct FbVar {
+    std::string name;
+    std::string type;
+    std::string comment;
+    std::string arraySize;
+    std::string initialValue;
+};
+
+// Экземпляр FB (или вложенного подприложения) в сети составного блока
+struct FbInstance {
+    std::string name;
+    std::string type;
+    double x = 0; // Координаты из файла, в единицах редактора
+    double y = 0;
+};
+
+enum class FbConnectionKind {
+    Event,
+    Data,
+    Adapter
+};
+
+// Соединение в сети: конец вида "ЭКЗЕМПЛЯР.ВЫВОД" или имя вывода самого блока
+struct FbConnection {
+    std::string source;
+    std::string destination;
+    FbConnectionKind kind = FbConnectionKind::Data;
+};
+
+// Сеть FB составного блока или подприложения (элемент FBNetwork)
+struct FbNetwork {
+    std::vector<FbInstance> instances;
+    std::vector<FbConnection> connections;
+
+    bool empty() const { return instances.empty() && connections.empty(); }
+};
+
+// Интерфейс функционального блока IEC 61499 - все, что нужно для отрисовки
+struct FbInterface {
+    std::string name;
+    std::string comment;
+    std::string version;
+    std::string packageName; // CompilerInfo packageName, например "eclipse4diac::math"
+    std::vector<FbEvent> eventInputs;
+    std::vector<FbEvent> eventOutputs;
+    std::vector<FbVar> inputVars;
+    std::vector<FbVar> outputVars;
+    FbNetwork network; // Пусто у базовых и сервисных блоков
+};
+
+#endif
@@ -0,0 +1,550 @@
+#include "fb_layout.h"
+#include "type_index.h"
+#include "utils.h"
+#include <algorithm>
+#include <unordered_map>
+
+namespace {
+    // Координаты сети в файле заданы в единицах редактора, примерно 5 на пиксель
+    const double NETWORK_COORDINATE_SCALE = 0.2;
+    const int NETWORK_PIN_SPACING = 14; // Шаг выводов экземпляра
+    const int NETWORK_PIN_STUB = 10;    // Длина выноса вывода за рамку
+    const int NETWORK_INTERFACE_SPACING = 18; // Шаг выводов интерфейса составного блока
+    const int NETWORK_INTERFACE_GAP = 120;    // Отступ колонок интерфейса от экземпляров
+
+    // Экземпляр в сети: рамка и выводы, известные по соединениям
+    struct NetworkBox {
+        const FbInstance* instance = nullptr;
+        int x = 0;
+        int y = 0;
+        int width = 0;
+        int height = 0;
+        std::vector<std::string> eventInputs;
+        std::vector<std::string> eventOutputs;
+        std::vector<std::string> dataInputs;
+        std::vector<std::string> dataOutputs;
+    };
+
+    // Точка подключения к выводу интерфейса составного блока
+    struct NetworkPort {
+        int x = 0;
+        int y = 0;
+    };
+
+    void addPinName(std::vector<std::string>& pins, const std::string& pin) {
+        if (std::find(pins.begin(), pins.end(), pin) == pins.end()) {
+            pins.push_back(pin);
+        }
+    }
+
+    // "ЭКЗЕМПЛЯР.ВЫВОД" -> экземпляр и вывод; без точки - вывод самого составного блока
+    bool splitEndpoint(const std::string& endpoint, std::string& instance, std::string& pin) {
+        size_t dot = endpoint.find('.');
+        if (dot == std::string::npos) {
+            instance.clear();
+            pin = endpoint;
+            return false;
+        }
+        instance = endpoint.substr(0, dot);
+        pin = endpoint.substr(dot + 1);
+        return true;
+    }
+
+    // Вертикальная позиция вывода: сначала события, затем данные
+    int pinY(const NetworkBox& box, const std::string& pin, bool input, bool event) {
+        const std::vector<std::string>& events = input ? box.eventInputs : box.eventOutputs;
+        const std::vector<std::string>& data = input ? box.dataInputs : box.dataOutputs;
+        int eventRows = static_cast<int>(std::max(box.eventInputs.size(), box.eventOutputs.size()));
+        int firstEventY = box.y + 26;
+        int firstDataY = firstEventY + eventRows * NETWORK_PIN_SPACING + (eventRows > 0 ? 6 : 0);
+        const std::vector<std::string>& pins = event ? events : data;
+        int index = static_cast<int>(std::find(pins.begin(), pins.end(), pin) - pins.begin());
+        return (event ? firstEventY : firstDataY) + index * NETWORK_PIN_SPACING;
+    }
+}
+
+void DiagramBounds::extend(int x0, int y0, int x1, int y1) {
+    if (isEmpty()) {
+        minX = x0;
+        minY = y0;
+        maxX = x1;
+        maxY = y1;
+        return;
+    }
+    minX = std::min(minX, x0);
+    minY = std::min(minY, y0);
+    maxX = std::max(maxX, x1);
+    maxY = std::max(maxY, y1);
+}
+
+DiagramLayout::DiagramLayout(GlyphCache& glyphCache)
+    : glyphCache_(glyphCache), list_(nullptr), metricsOnly_(false) {}
+
+const CachedGlyph& DiagramLayout::getGlyph(char32_t codepoint, int fontSize, bool italic, bool bold) {
+    return metricsOnly_ ? glyphCache_.getMetrics(codepoint, fontSize, italic, bold)
+                        : glyphCache_.getGlyph(codepoint, fontSize, italic, bold);
+}
+
+// Вычисление ширины текста в пикселях
+int DiagramLayout::getTextWidth(const std::string& text, int fontSize) {
+    std::u32string codepoints = utils::decodeUtf8(text);
+
+    if (!glyphCache_.hasFont()) {
+        return codepoints.size() * fontSize * 0.6;
+    }
+
+    // Ширина складывается из сдвигов глифов, которые уже лежат в кэше
+    // и будут повторно использованы при отрисовке
+    int width = 0;
+    for (char32_t c : codepoints) {
+        width += getGlyph(c, fontSize, false).advance;
+    }
+    
+    return width;
+}
+
+void DiagramLayout::addRectangle(int x, int y, int width, int height, Color color, bool fill) {
+    DisplayItem item;
+    item.type = DisplayItemType::Rectangle;
+    item.x = x;
+    item.y = y;
+    item.width = width;
+    item.height = height;
+    item.color = color;
+    item.fill = fill;
+    list_->items.push_back(item);
+
+    if (width > 0 && height > 0) {
+        list_->bounds.extend(x, y, x + width - 1, y + height - 1);
+    }
+}
+
+void DiagramLayout::addLine(int x1, int y1, int x2, int y2, Color color, int thickness) {
+    DisplayItem item;
+    item.type = DisplayItemType::Line;
+    item.x = x1;
+    item.y = y1;
+    item.x2 = x2;
+    item.y2 = y2;
+    item.color = color;
+    item.thickness = thickness;
+    list_->items.push_back(item);
+
+    list_->bounds.extend(std::min(x1, x2) - thickness/2, std::min(y1, y2) - thickness/2,
+                         std::max(x1, x2) + thickness/2, std::max(y1, y2) + thickness/2);
+}
+
+void DiagramLayout::addTriangle(int x, int y, int size, Color color) {
+    DisplayItem item;
+    item.type = DisplayItemType::Triangle;
+    item.x = x;
+    item.y = y;
+    item.size = size;
+    item.color = color;
+    list_->items.push_back(item);
+
+    // Закрашиваются только точки справа от центра
+    list_->bounds.extend(x, y - size/2, x + size/2, y + size/2);
+}
+
+void DiagramLayout::addSquare(int x, int y, int size, Color color, bool fill) {
+    DisplayItem item;
+    item.type = DisplayItemType::Square;
+    item.x = x;
+    item.y = y;
+    item.size = size;
+    item.color = color;
+    item.fill = fill;
+    list_->items.push_back(item);
+
+    if (size > 0) {
+        list_->bounds.extend(x - size/2, y - size/2, x - size/2 + size - 1, y - size/2 + size - 1);
+    }
+}
+
+void DiagramLayout::addText(const std::string& text, int x, int y, Color color,
+                            int fontSize, bool italic, bool bold) {
+    DisplayItem item;
+    item.type = DisplayItemType::Text;
+    item.x = x;
+    item.y = y;
+    item.color = color;
+    item.text = text;
+    item.fontSize = fontSize;
+    item.italic = italic;
+    item.bold = bold;
+    list_->items.push_back(item);
+
+    if (!glyphCache_.hasFont()) {
+        return; // Без шрифта текст не рисуется
+    }
+
+    // Границы текста - реальные границы битмапов глифов;
+    // базовая линия смещена на fontSize/2, как при отрисовке
+    int baseline = y + fontSize / 2;
+    int pen_x = x;
+    for (char32_t c : utils::decodeUtf8(text)) {
+        const CachedGlyph& glyph = getGlyph(c, fontSize, italic, bold);
+        if (glyph.width > 0 && glyph.rows > 0) {
+            list_->bounds.extend(pen_x + glyph.left, baseline - glyph.top,
+                                 pen_x + glyph.left + glyph.width - 1,
+                                 baseline - glyph.top + glyph.rows - 1);
+        }
+        pen_x += glyph.advance;
+    }
+}
+
+// Разметка диаграммы функционального блока
+DisplayList DiagramLayout::layout(const FbInterface& fb) {
+    DisplayList list;
+    list_ = &list;
+
+    const Color black = {0, 0, 0};
+    const Color green = {0, 255, 0};
+    const Color blue = {0, 0, 255};
+
+    const std::vector<FbEvent>& eventInputs = fb.eventInputs;
+    const std::vector<FbEvent>& eventOutputs = fb.eventOutputs;
+    const std::vector<FbVar>& inputVars = fb.inputVars;
+    const std::vector<FbVar>& outputVars = fb.outputVars;
+
+    // Расчет размеров текста
+    int nameWidth = getTextWidth(fb.name, 12);
+    int versionWidth = getTextWidth("v" + fb.version, 8);
+    
+    // Расчет размеров основного блока
+    int maxEvents = std::max(eventInputs.size(), eventOutputs.size());
+    int maxVars = std::max(inputVars.size(), outputVars.size());
+    
+    int mainBlockWidth = std::max(200, std::max(nameWidth, versionWidth) + 40);
+    int mainBlockHeight = 80 + (maxEvents * 25) + (maxVars * 20);
+    
+    // Минимальные размеры блока
+    mainBlockWidth = std::max(mainBlockWidth, 200);
+    mainBlockHeight = std::max(mainBlockHeight, 100);
+
+    const int mainBlockX = 0;
+    const int mainBlockY = 0;
+
+    // Основной прямоугольник
+    addRectangle(mainBlockX, mainBlockY, mainBlockWidth, mainBlockHeight, black);
+    
+    // Название функционального блока
+    addText(fb.name, mainBlockX + mainBlockWidth/2 - nameWidth/2, 
+            mainBlockY + mainBlockHeight/2 - 8, black, 12, true);
+    
+    // Версия
+    addText("v" + fb.version, mainBlockX + mainBlockWidth/2 - versionWidth/2, 
+            mainBlockY + mainBlockHeight/2 + 8, black, 8, false);
+
+    // Координата для квадратиков слева
+    int squareX = mainBlockX - 15;
+
+    // Входные события (левая сторона)
+    int eventInputY = mainBlockY + 25;
+    for (size_t i = 0; i < eventInputs.size(); i++) {
+        int currentY = eventInputY + i * 22;
+        
+        // Квадратик
+        addSquare(squareX, currentY, 8, black, false);
+        
+        // Линия от квадратика к блоку
+        addLine(squareX, currentY, mainBlockX, currentY, black, 1);
+        
+        // Линия наружу
+        addLine(mainBlockX - 30, currentY, squareX, currentY, black, 1);
+        
+        // Зеленый треугольник для первой линии
+        if (i == 0) {
+            addTriangle(mainBlockX, currentY, 10, green);
+        }
+        
+        // Текст "Event"
+        addText("Event", mainBlockX - 70, currentY - 4, black, 8, false);
+        
+        // Название события
+        addText(eventInputs[i].name, mainBlockX + 8, currentY - 4, black, 9, false);
+    }
+
+    // Выходные события (правая сторона)
+    int eventOutputY = mainBlockY + 25;
+    for (size_t i = 0; i < eventOutputs.size(); i++) {
+        int currentY = eventOutputY + i * 22;
+        
+        // Зеленый треугольник для первой линии
+        if (i == 0) {
+            addTriangle(mainBlockX + mainBlockWidth - 5, currentY, 10, green);
+        }
+        
+        // Линия наружу
+        addLine(mainBlockX + mainBlockWidth, currentY, mainBlockX + mainBlockWidth + 30, currentY, black, 1);
+        
+        // Текст "Event"
+        addText("Event", mainBlockX + mainBlockWidth + 35, currentY - 4, black, 8, false);
+        
+        // Название события
+        addText(eventOutputs[i].name, mainBlockX + mainBlockWidth - 40, currentY - 4, black, 9, false);
+    }
+
+    // Входные переменные (левая сторона)
+    int inputStartY = mainBlockY + mainBlockHeight/2 + 20;
+    for (size_t i = 0; i < inputVars.size(); i++) {
+        int yPos = inputStartY + i * 18;
+        
+        // Квадратик
+        addSquare(squareX, yPos, 8, black, false);
+        
+        // Линия от квадратика к блоку
+        addLine(squareX, yPos, mainBlockX, yPos, black, 1);
+        
+        // Линия наружу
+        addLine(mainBlockX - 45, yPos, squareX, yPos, black, 1);
+        
+        // Синий треугольник
+        addTriangle(mainBlockX, yPos, 8, blue);
+        
+        // Имя переменной
+        addText(inputVars[i].name, mainBlockX + 8, yPos - 4, black, 9, false);
+        
+        // Тип переменной
+        addText(inputVars[i].type, mainBlockX - 110, yPos - 4, black, 7, false);
+    }
+
+    // Выходные переменные (правая сторона)
+    int outputStartY = mainBlockY + mainBlockHeight/2 + 20;
+    for (size_t i = 0; i < outputVars.size(); i++) {
+        int yPos = outputStartY + i * 18;
+        
+        // Синий треугольник
+        addTriangle(mainBlockX + mainBlockWidth - 5, yPos, 8, blue);
+        
+        // Линия наружу
+        addLine(mainBlockX + mainBlockWidth, yPos, mainBlockX + mainBlockWidth + 45, yPos, black, 1);
+        
+        // Имя переменной
+        addText(outputVars[i].name, mainBlockX + mainBlockWidth - 40, yPos - 4, black, 9, false);
+        
+        // Тип переменной
+        addText(outputVars[i].type, mainBlockX + mainBlockWidth + 50, yPos - 4, black, 7, false);
+    }
+
+    // Вертикальная линия, соединяющая квадратики
+    if (!eventInputs.empty() || !inputVars.empty()) {
+        // Первая линия - первое событие, иначе первая переменная
+        int firstLineY = !eventInputs.empty() ? eventInputY : inputStartY;
+        
+        // Последняя линия - последняя переменная, иначе последнее событие
+        int lastLineY = !inputVars.empty()
+            ? inputStartY + static_cast<int>(inputVars.size() - 1) * 18
+            : eventInputY + static_cast<int>(eventInputs.size() - 1) * 22;
+        
+        if (firstLineY != lastLineY) {
+            addLine(squareX, firstLineY, squareX, lastLineY, black, 1);
+        }
+    }
+
+    list_ = nullptr;
+    return list;
+}
+
+// Ортогональная ломаная соединения
+void DiagramLayout::addConnection(int x1, int y1, int x2, int y2, int bypassY, Color color) {
+    if (x2 - NETWORK_PIN_STUB > x1 + NETWORK_PIN_STUB) {
+        // Вход правее выхода: горизонталь, вертикаль посередине, горизонталь
+        int midX = (x1 + x2) / 2;
+        addLine(x1, y1, midX, y1, color);
+        if (y1 != y2) {
+            addLine(midX, y1, midX, y2, color);
+        }
+        addLine(midX, y2, x2, y2, color);
+        return;
+    }
+
+    // Обратная связь: вынос вправо, обход под рамками, подход ко входу слева
+    int outX = x1 + NETWORK_PIN_STUB;
+    int inX = x2 - NETWORK_PIN_STUB;
+    addLine(x1, y1, outX, y1, color);
+    addLine(outX, y1, outX, bypassY, color);
+    addLine(outX, bypassY, inX, bypassY, color);
+    addLine(inX, bypassY, inX, y2, color);
+    addLine(inX, y2, x2, y2, color);
+}
+
+// Разметка сети составного блока
+DisplayList DiagramLayout::layoutNetwork(const FbInterface& fb, const TypeIndex* types) {
+    DisplayList list;
+    list_ = &list;
+
+    const Color black = {0, 0, 0};
+    const Color green = {0, 255, 0};
+    const Color blue = {0, 0, 255};
+    const FbNetwork& network = fb.network;
+
+    // Экземпляры по имени; выводы - из интерфейса типа, затем из концов соединений
+    // (адаптеры и выводы типов, которых нет в индексе)
+    std::vector<NetworkBox> boxes(network.instances.size());
+    std::unordered_map<std::string, size_t> boxByName;
+    for (size_t i = 0; i < network.instances.size(); i++) {
+        NetworkBox& box = boxes[i];
+        box.instance = &network.instances[i];
+        boxByName[box.instance->name] = i;
+
+        std::shared_ptr<const FbInterface> type = types ? types->resolve(box.instance->type) : nullptr;
+        if (type) {
+            for (const FbEvent& event : type->eventInputs) box.eventInputs.push_back(event.name);
+            for (const FbEvent& event : type->eventOutputs) box.eventOutputs.push_back(event.name);
+            for (const FbVar& var : type->inputVars) box.dataInputs.push_back(var.name);
+            for (const FbVar& var : type->outputVars) box.dataOutputs.push_back(var.name);
+        }
+    }
+
+    std::string instance;
+    std::string pin;
+    for (const FbConnection& connection : network.connections) {
+        bool event = connection.kind == FbConnectionKind::Event;
+        if (splitEndpoint(connection.source, instance, pin)) {
+            auto it = boxByName.find(instance);
+            if (it != boxByName.end()) {
+                addPinName(event ? boxes[it->second].eventOutputs : boxes[it->second].dataOutputs, pin);
+            }
+        }
+        if (splitEndpoint(connection.destination, instance, pin)) {
+            auto it = boxByName.find(instance);
+            if (it != boxByName.end()) {
+                addPinName(event ? boxes[it->second].eventInputs : boxes[it->second].dataInputs, pin);
+            }
+        }
+    }
+
+    // Размеры рамок: заголовок с типом, затем строки событий и данных
+    int minX = 0, minY = 0, maxX = 0;
+    for (size_t i = 0; i < boxes.size(); i++) {
+        NetworkBox& box = boxes[i];
+        int widestInput = 0;
+        int widestOutput = 0;
+        for (const std::string& name : box.eventInputs) widestInput = std::max(widestInput, getTextWidth(name, 7));
+        for (const std::string& name : box.dataInputs) widestInput = std::max(widestInput, getTextWidth(name, 7));
+        for (const std::string& name : box.eventOutputs) widestOutput = std::max(widestOutput, getTextWidth(name, 7));
+        for (const std::string& name : box.dataOutputs) widestOutput = std::max(widestOutput, getTextWidth(name, 7));
+
+        int eventRows = static_cast<int>(std::max(box.eventInputs.size(), box.eventOutputs.size()));
+        int dataRows = static_cast<int>(std::max(box.dataInputs.size(), box.dataOutputs.size()));
+
+        box.x = static_cast<int>(box.instance->x * NETWORK_COORDINATE_SCALE);
+        box.y = static_cast<int>(box.instance->y * NETWORK_COORDINATE_SCALE);
+        box.width = std::max({90, getTextWidth(box.instance->type, 8) + 20, widestInput + widestOutput + 24});
+        box.height = std::max(40, 26 + eventRows * NETWORK_PIN_SPACING +
+                                  (eventRows > 0 && dataRows > 0 ? 6 : 0) + dataRows * NETWORK_PIN_SPACING);
+
+        if (i == 0) {
+            minX = box.x;
+            minY = box.y;
+            maxX = box.x + box.width;
+        } else {
+            minX = std::min(minX, box.x);
+            minY = std::min(minY, box.y);
+            maxX = std::max(maxX, box.x + box.width);
+        }
+    }
+
+    // Рамки экземпляров: имя над рамкой, тип в заголовке, выводы с выносами
+    for (const NetworkBox& box : boxes) {
+        const std::string& name = box.instance->name;
+        const std::string& type = box.instance->type;
+        addText(name, box.x + box.width/2 - getTextWidth(name, 9)/2, box.y - 10, black, 9, false);
+        addRectangle(box.x, box.y, box.width, box.height, black);
+        addText(type, box.x + box.width/2 - getTextWidth(type, 8)/2, box.y + 8, black, 8, true);
+        addLine(box.x, box.y + 16, box.x + box.width - 1, box.y + 16, black);
+
+        for (int input = 1; input >= 0; input--) {
+            for (int event = 1; event >= 0; event--) {
+                const std::vector<std::string>& pins = input
+                    ? (event ? box.eventInputs : box.dataInputs)
+                    : (event ? box.eventOutputs : box.dataOutputs);
+                Color color = event ? green : blue;
+                for (const std::string& pinName : pins) {
+                    int y = pinY(box, pinName, input, event);
+                    if (input) {
+                        addLine(box.x - NETWORK_PIN_STUB, y, box.x, y, color);
+                        addText(pinName, box.x + 4, y - 4, black, 7, false);
+                    } else {
+                        int right = box.x + box.width;
+                        addLine(right, y, right + NETWORK_PIN_STUB, y, color);
+                        addText(pinName, right - 4 - getTextWidth(pinName, 7), y - 4, black, 7, false);
+                    }
+                }
+            }
+        }
+    }
+
+    // Выводы интерфейса составного блока: входы слева от сети, выходы справа
+    std::unordered_map<std::string, NetworkPort> inputPorts;
+    std::unordered_map<std::string, NetworkPort> outputPorts;
+    int leftX = minX - NETWORK_INTERFACE_GAP;
+    int rightX = maxX + NETWORK_INTERFACE_GAP;
+
+    int portY = minY;
+    auto addInputPort = [&](const std::string& name, Color color) {
+        addSquare(leftX, portY, 8, color, true);
+        addText(name, leftX - 8 - getTextWidth(name, 9), portY - 4, black, 9, false);
+        inputPorts[name] = {leftX + 4, portY};
+        portY += NETWORK_INTERFACE_SPACING;
+    };
+    for (const FbEvent& event : fb.eventInputs) addInputPort(event.name, green);
+    for (const FbVar& var : fb.inputVars) addInputPort(var.name, blue);
+
+    portY = minY;
+    auto addOutputPort = [&](const std::string& name, Color color) {
+        addSquare(rightX, portY, 8, color, true);
+        addText(name, rightX + 8, portY - 4, black, 9, false);
+        outputPorts[name] = {rightX - 4, portY};
+        portY += NETWORK_INTERFACE_SPACING;
+    };
+    for (const FbEvent& event : fb.eventOutputs) addOutputPort(event.name, green);
+    for (const FbVar& var : fb.outputVars) addOutputPort(var.name, blue);
+
+    addText(fb.name, leftX, minY - 40, black, 12, true);
+
+    // Соединения; концы с неизвестными экземплярами или выводами пропускаются
+    for (const FbConnection& connection : network.connections) {
+        bool event = connection.kind == FbConnectionKind::Event;
+        Color color = event ? green : connection.kind == FbConnectionKind::Data ? blue : black;
+
+        int x1 = 0, y1 = 0, x2 = 0, y2 = 0;
+        int bypassY = 0;
+        if (splitEndpoint(connection.source, instance, pin)) {
+            auto it = boxByName.find(instance);
+            if (it == boxByName.end()) continue;
+            const NetworkBox& box = boxes[it->second];
+            x1 = box.x + box.width + NETWORK_PIN_STUB;
+            y1 = pinY(box, pin, false, event);
+            bypassY = box.y + box.height;
+        } else {
+            auto it = inputPorts.find(pin);
+            if (it == inputPorts.end()) continue;
+            x1 = it->second.x;
+            y1 = it->second.y;
+            bypassY = y1;
+        }
+
+        if (splitEndpoint(connection.destination, instance, pin)) {
+            auto it = boxByName.find(instance);
+            if (it == boxByName.end()) continue;
+            const NetworkBox& box = boxes[it->second];
+            x2 = box.x - NETWORK_PIN_STUB;
+            y2 = pinY(box, pin, true, event);
+            bypassY = std::max(bypassY, box.y + box.height);
+        } else {
+            auto it = outputPorts.find(pin);
+            if (it == outputPorts.end()) continue;
+            x2 = it->second.x;
+            y2 = it->second.y;
+            bypassY = std::max(bypassY, y2);
+        }
+
+        addConnection(x1, y1, x2, y2, bypassY + 10, color);
+    }
+
+    list_ = nullptr;
+    return list;
+}
@@ -0,0 +1,102 @@
+#ifndef FB_LAYOUT_H
+#define FB_LAYOUT_H
+
+#include "fb_interface.h"
+#include "glyph_cache.h"
+#include <string>
+#include <vector>
+
+class TypeIndex;
+
+// Ограничивающий прямоугольник нарисованных элементов (включительно)
+struct DiagramBounds {
+    int minX = 0;
+    int minY = 0;
+    int maxX = -1;
+    int maxY = -1;
+    
+    bool isEmpty() const { return maxX < minX || maxY < minY; }
+    int getWidth() const { return isEmpty() ? 0 : maxX - minX + 1; }
+    int getHeight() const { return isEmpty() ? 0 : maxY - minY + 1; }
+    void extend(int x0, int y0, int x1, int y1);
+};
+
+struct Color {
+    unsigned char r = 0;
+    unsigned char g = 0;
+    unsigned char b = 0;
+};
+
+enum class DisplayItemType {
+    Rectangle, // (x, y) - левый верхний угол, width x height
+    Line,      // Отрезок (x, y) - (x2, y2) толщиной thickness
+    Triangle,  // Треугольник острием вправо, (x, y) - центр, size - размер
+    Square,    // Квадрат с центром (x, y) и стороной size
+    Text       // Строка: (x, y) - начало пера и верх строки, как в ImageGenerator::drawText
+};
+
+// Элемент списка отображения с уже вычисленными координатами
+struct DisplayItem {
+    DisplayItemType type = DisplayItemType::Line;
+    int x = 0;
+    int y = 0;
+    int x2 = 0;
+    int y2 = 0;
+    int width = 0;
+    int height = 0;
+    int size = 0;
+    int thickness = 1;
+    bool fill = false;
+    Color color;
+    std::string text;
+    int fontSize = 10;
+    bool italic = false;
+    bool bold = false;
+};
+
+// Результат разметки диаграммы: примитивы и их общие границы.
+// Не зависит от способа вывода и может использоваться повторно.
+struct DisplayList {
+    std::vector<DisplayItem> items;
+    DiagramBounds bounds;
+};
+
+// Разметка диаграммы функционального блока.
+// Превращает интерфейс FB в список отображения; метрики текста берутся из кэша глифов.
+// Основной блок размещается с левым верхним углом в точке (0, 0).
+class DiagramLayout {
+public:
+    explicit DiagramLayout(GlyphCache& glyphCache);
+
+    DisplayList layout(const FbInterface& fb);
+    // Сеть составного блока (fb.network): экземпляры FB по координатам из файла,
+    // выводы интерфейса самого блока по краям, соединения - ортогональные ломаные.
+    // Выводы экземпляра берутся из интерфейса его типа в types; для типов,
+    // которых там нет, - только выводы, упомянутые в соединениях
+    DisplayList layoutNetwork(const FbInterface& fb, const TypeIndex* types = nullptr);
+
+    // Только метрики глифов, без растеризации (для векторного вывода)
+    void setMetricsOnly(bool metricsOnly) { metricsOnly_ = metricsOnly; }
+
+    // Ширина строки в пикселях (сумма сдвигов глифов)
+    int getTextWidth(const std::string& text, int fontSize);
+
+private:
+    GlyphCache& glyphCache_;
+    DisplayList* list_; // Список, заполняемый текущим вызовом layout()
+    bool metricsOnly_;
+
+    const CachedGlyph& getGlyph(char32_t codepoint, int fontSize, bool italic, bool bold = false);
+
+    void addRectangle(int x, int y, int width, int height, Color color, bool fill = false);
+    void addLine(int x1, int y1, int x2, int y2, Color color, int thickness = 1);
+    void addTriangle(int x, int y, int size, Color color);
+    void addSquare(int x, int y, int size, Color color, bool fill = false);
+    void addText(const std::string& text, int x, int y, Color color,
+                 int fontSize, bool italic = false, bool bold = false);
+    // Ортогональная ломаная от выхода (x1, y1) ко входу (x2, y2);
+    // если вход левее выхода, обход идет по горизонтали bypassY
+    void addConnection(int x1, int y1, int x2, int y2, int bypassY, Color color);
+};
+
+#endif
@@ -0,0 +1,64 @@
+#include "fbt_render.h"
+#include "utils.h"
+
+FbtRenderer::FbtRenderer(const RenderOptions& options)
+    : options_(options), loaded_(false), width_(0), height_(0) {
+    utils::ScopedLogCapture capture;
+    generator_ = std::make_unique<ImageGenerator>();
+    generator_->setPngOptions(options_.png);
+    generator_->setMargin(options_.margin);
+    generator_->setOutputFormat(options_.format);
+    log_ = capture.str();
+}
+
+bool FbtRenderer::load(const char* xml, size_t size) {
+    utils::ScopedLogCapture capture;
+    loaded_ = false;
+    width_ = 0;
+    height_ = 0;
+
+    if (xml && parser_.parseBuffer(xml, size)) {
+        list_ = generator_->layoutDiagram(parser_.getInterface());
+        generator_->getCanvasSize(list_, width_, height_);
+        loaded_ = true;
+    } else {
+        utils::logErr() << "Failed to parse FBT document" << std::endl;
+    }
+
+    log_ = capture.str();
+    return loaded_;
+}
+
+bool FbtRenderer::encode(std::vector<unsigned char>& output) {
+    if (!loaded_) {
+        log_ = "No document loaded\n";
+        return false;
+    }
+
+    utils::ScopedLogCapture capture;
+    bool success = generator_->encodeDisplayList(list_, output);
+    log_ = capture.str();
+    return success;
+}
+
+bool FbtRenderer::renderRgb(unsigned char* rgb, int stride) {
+    if (!loaded_ || !rgb || stride < width_ * 3) {
+        log_ = "No document loaded or buffer too small\n";
+        return false;
+    }
+
+    utils::ScopedLogCapture capture;
+    generator_->renderToBuffer(list_, rgb, stride);
+    log_ = capture.str();
+    return true;
+}
+
+bool FbtRenderer::render(const char* xml, size_t size, std::vector<unsigned char>& output) {
+    if (!load(xml, size)) {
+        return false;
+    }
+    std::string loadLog = log_;
+    bool success = encode(output);
+    log_ = loadLog + log_;
+    return success;
+}
@@ -0,0 +1,59 @@
+#ifndef FBT_RENDER_H
+#define FBT_RENDER_H
+
+#include "fb_interface.h"
+#include "fb_layout.h"
+#include "image_generator.h"
+#include "xml_parser.h"
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Настройки встраиваемого рендерера
+struct RenderOptions {
+    OutputFormat format = OutputFormat::Png;
+    PngOptions png;
+    int margin = 10; // Поля вокруг диаграммы в пикселях
+};
+
+// Встраиваемый интерфейс библиотеки: FBT из памяти -> изображение в памяти.
+// Объект держит загруженный шрифт и кэш глифов между вызовами. Он не
+// потокобезопасен: для параллельной работы нужен объект на поток.
+// Журнал генератора не выводится в stdout, а сохраняется и доступен через getLog().
+class FbtRenderer {
+public:
+    explicit FbtRenderer(const RenderOptions& options = RenderOptions());
+
+    // Разбор и разметка документа; после успешной загрузки доступны
+    // размер холста, encode() и renderRgb()
+    bool load(const char* xml, size_t size);
+    bool isLoaded() const { return loaded_; }
+    const FbInterface& getInterface() const { return parser_.getInterface(); }
+    int getWidth() const { return width_; }
+    int getHeight() const { return height_; }
+
+    // PNG или SVG (по настройкам) загруженного документа
+    bool encode(std::vector<unsigned char>& output);
+    // Растеризация в буфер вызывающего: RGB, 3 байта на пиксель, stride байт в строке,
+    // не меньше getWidth() x getHeight()
+    bool renderRgb(unsigned char* rgb, int stride);
+
+    // Загрузка и кодирование за один вызов
+    bool render(const char* xml, size_t size, std::vector<unsigned char>& output);
+
+    const std::string& getLog() const { return log_; } // Журнал последнего вызова
+    GlyphCacheStats getGlyphCacheStats() const { return generator_->getGlyphCacheStats(); }
+
+private:
+    RenderOptions options_;
+    XmlParser parser_;
+    std::unique_ptr<ImageGenerator> generator_; // Создается под перехватом журнала
+    DisplayList list_;
+    bool loaded_;
+    int width_;
+    int height_;
+    std::string log_;
+};
+
+#endif
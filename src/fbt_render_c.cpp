@@ -0,0 +1,100 @@
+#include "fbt_render_c.h"
+#include "fbt_render.h"
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+
+struct fbt_renderer {
+    FbtRenderer renderer;
+    std::string error; // Ошибка, возникшая вне рендерера (исключение)
+
+    explicit fbt_renderer(const RenderOptions& options) : renderer(options) {}
+};
+
+// Исключения не должны пересекать границу C-интерфейса
+template <typename Function>
+static int guarded(fbt_renderer* handle, Function function) {
+    if (!handle) {
+        return -1;
+    }
+    try {
+        handle->error.clear();
+        return function() ? 0 : -1;
+    } catch (const std::exception& e) {
+        handle->error = e.what();
+        return -1;
+    }
+}
+
+fbt_renderer* fbt_renderer_create(int format, int margin, int png_level) {
+    RenderOptions options;
+    options.format = format == FBT_FORMAT_SVG ? OutputFormat::Svg : OutputFormat::Png;
+    options.margin = margin < 0 ? 0 : margin;
+    if (png_level >= 0 && png_level <= 9) {
+        options.png.compressionLevel = png_level;
+    }
+    try {
+        return new fbt_renderer(options);
+    } catch (const std::exception&) {
+        return nullptr;
+    }
+}
+
+void fbt_renderer_destroy(fbt_renderer* renderer) {
+    delete renderer;
+}
+
+int fbt_renderer_load(fbt_renderer* renderer, const char* xml, size_t size) {
+    return guarded(renderer, [&] { return renderer->renderer.load(xml, size); });
+}
+
+int fbt_renderer_get_size(const fbt_renderer* renderer, int* width, int* height) {
+    if (!renderer || !renderer->renderer.isLoaded()) {
+        return -1;
+    }
+    if (width) {
+        *width = renderer->renderer.getWidth();
+    }
+    if (height) {
+        *height = renderer->renderer.getHeight();
+    }
+    return 0;
+}
+
+int fbt_renderer_render_rgb(fbt_renderer* renderer, unsigned char* rgb, int stride) {
+    return guarded(renderer, [&] { return renderer->renderer.renderRgb(rgb, stride); });
+}
+
+int fbt_renderer_encode(fbt_renderer* renderer, unsigned char** data, size_t* size) {
+    if (!data || !size) {
+        return -1;
+    }
+    *data = nullptr;
+    *size = 0;
+    return guarded(renderer, [&] {
+        std::vector<unsigned char> output;
+        if (!renderer->renderer.encode(output)) {
+            return false;
+        }
+        // Буфер выделяется malloc, чтобы вызывающий мог освободить его без C++
+        unsigned char* buffer = static_cast<unsigned char*>(std::malloc(output.empty() ? 1 : output.size()));
+        if (!buffer) {
+            return false;
+        }
+        std::memcpy(buffer, output.data(), output.size());
+        *data = buffer;
+        *size = output.size();
+        return true;
+    });
+}
+
+void fbt_free(void* data) {
+    std::free(data);
+}
+
+const char* fbt_renderer_last_log(const fbt_renderer* renderer) {
+    if (!renderer) {
+        return "";
+    }
+    return renderer->error.empty() ? renderer->renderer.getLog().c_str() : renderer->error.c_str();
+}
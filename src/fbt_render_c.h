@@ -0,0 +1,56 @@
+#ifndef FBT_RENDER_C_H
+#define FBT_RENDER_C_H
+
+/* C-интерфейс библиотеки fbt_render - для вызова из других языков (JNI, JNA, ctypes).
+ * Функции возвращают 0 при успехе и -1 при ошибке; подробности - fbt_renderer_last_log. */
+
+#include <stddef.h>
+
+#if defined(FBT_RENDER_SHARED)
+#  if defined(_WIN32)
+#    if defined(FBT_RENDER_BUILDING)
+#      define FBT_RENDER_API __declspec(dllexport)
+#    else
+#      define FBT_RENDER_API __declspec(dllimport)
+#    endif
+#  else
+#    define FBT_RENDER_API __attribute__((visibility("default")))
+#  endif
+#else
+#  define FBT_RENDER_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct fbt_renderer fbt_renderer;
+
+enum {
+    FBT_FORMAT_PNG = 0,
+    FBT_FORMAT_SVG = 1
+};
+
+/* png_level: 0-9 или -1 для уровня по умолчанию */
+FBT_RENDER_API fbt_renderer* fbt_renderer_create(int format, int margin, int png_level);
+FBT_RENDER_API void fbt_renderer_destroy(fbt_renderer* renderer);
+
+/* Разбор и разметка документа из памяти */
+FBT_RENDER_API int fbt_renderer_load(fbt_renderer* renderer, const char* xml, size_t size);
+FBT_RENDER_API int fbt_renderer_get_size(const fbt_renderer* renderer, int* width, int* height);
+
+/* Растеризация загруженного документа в буфер вызывающего (RGB, stride байт в строке) */
+FBT_RENDER_API int fbt_renderer_render_rgb(fbt_renderer* renderer, unsigned char* rgb, int stride);
+
+/* PNG или SVG загруженного документа; *data освобождается через fbt_free */
+FBT_RENDER_API int fbt_renderer_encode(fbt_renderer* renderer, unsigned char** data, size_t* size);
+FBT_RENDER_API void fbt_free(void* data);
+
+/* Журнал последнего вызова; строка действительна до следующего вызова */
+FBT_RENDER_API const char* fbt_renderer_last_log(const fbt_renderer* renderer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,218 @@
+#include "file_discovery.h"
+#include "thread_pool.h"
+#include "utils.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+
+namespace {
+    bool matchFrom(const char* pattern, const char* text) {
+        while (*pattern) {
+            if (pattern[0] == '*' && pattern[1] == '*') {
+                pattern += 2;
+                if (*pattern == '/') {
+                    // "**/" - ноль или больше целых компонентов пути
+                    pattern++;
+                    for (const char* t = text; ; ++t) {
+                        if ((t == text || t[-1] == '/') && matchFrom(pattern, t)) {
+                            return true;
+                        }
+                        if (!*t) {
+                            return false;
+                        }
+                    }
+                }
+                // "**" в конце или внутри компонента - любые символы, включая '/'
+                for (const char* t = text; ; ++t) {
+                    if (matchFrom(pattern, t)) {
+                        return true;
+                    }
+                    if (!*t) {
+                        return false;
+                    }
+                }
+            }
+            if (*pattern == '*') {
+                pattern++;
+                for (const char* t = text; ; ++t) {
+                    if (matchFrom(pattern, t)) {
+                        return true;
+                    }
+                    if (!*t || *t == '/') {
+                        return false;
+                    }
+                }
+            }
+            if (!*text || (*pattern == '?' ? *text == '/' : *pattern != *text)) {
+                return false;
+            }
+            pattern++;
+            text++;
+        }
+        return *text == 0;
+    }
+
+    // Маска без '/' относится только к последнему компоненту пути
+    bool matchPath(const std::string& pattern, const std::string& relativePath) {
+        if (pattern.find('/') == std::string::npos) {
+            size_t slash = relativePath.rfind('/');
+            std::string name = slash == std::string::npos ? relativePath : relativePath.substr(slash + 1);
+            return FileDiscovery::matchGlob(pattern, name);
+        }
+        return FileDiscovery::matchGlob(pattern, relativePath);
+    }
+}
+
+FileDiscovery::FileDiscovery(const DiscoveryOptions& options)
+    : options_(options), extensionLower_(options.extension) {
+    // Расширение приводится к нижнему регистру один раз, а не для каждого файла
+    std::transform(extensionLower_.begin(), extensionLower_.end(), extensionLower_.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+}
+
+bool FileDiscovery::matchGlob(const std::string& pattern, const std::string& path) {
+    return matchFrom(pattern.c_str(), path.c_str());
+}
+
+bool FileDiscovery::isIncluded(const std::string& relativePath) const {
+    if (options_.includes.empty()) {
+        return true;
+    }
+    for (const auto& pattern : options_.includes) {
+        if (matchPath(pattern, relativePath)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool FileDiscovery::isExcluded(const std::string& relativePath) const {
+    for (const auto& pattern : options_.excludes) {
+        if (matchPath(pattern, relativePath)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool FileDiscovery::isDirectoryExcluded(const std::string& relativeDir) const {
+    if (relativeDir.empty()) {
+        return false;
+    }
+    for (size_t end = relativeDir.find('/'); ; end = relativeDir.find('/', end + 1)) {
+        std::string directory = relativeDir.substr(0, end);
+        if (isExcluded(directory) || isExcluded(directory + "/")) {
+            return true;
+        }
+        if (end == std::string::npos) {
+            return false;
+        }
+    }
+}
+
+bool FileDiscovery::isSelected(const std::string& relativePath) const {
+    size_t slash = relativePath.rfind('/');
+    if (slash != std::string::npos && (!options_.recursive || isDirectoryExcluded(relativePath.substr(0, slash)))) {
+        return false;
+    }
+    return isIncluded(relativePath) && !isExcluded(relativePath);
+}
+
+bool FileDiscovery::hasExtension(const std::string& fileName) const {
+    if (fileName.size() < extensionLower_.size()) {
+        return false;
+    }
+    size_t offset = fileName.size() - extensionLower_.size();
+    for (size_t i = 0; i < extensionLower_.size(); i++) {
+        if (std::tolower(static_cast<unsigned char>(fileName[offset + i])) != extensionLower_[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t FileDiscovery::discover(const std::string& root, const FileCallback& onFile,
+                               const DirectoryCallback& onDirectory, const std::string& relativeRoot) {
+    namespace fs = std::filesystem;
+
+    std::error_code ec;
+    if (!fs::is_directory(root, ec)) {
+        utils::logErr() << "Directory does not exist: " << root << std::endl;
+        return 0;
+    }
+
+    std::mutex callbackMutex;
+    std::atomic<size_t> found(0);
+    std::unique_ptr<ThreadPool> pool;
+    if (options_.jobs > 1 && options_.recursive) {
+        pool = std::make_unique<ThreadPool>(static_cast<size_t>(options_.jobs));
+    }
+
+    // Обход одной директории; поддиректории уходят в пул отдельными задачами
+    std::function<void(const fs::path&, const std::string&)> visit =
+        [&](const fs::path& directory, const std::string& relativeDir) {
+        if (onDirectory) {
+            std::lock_guard<std::mutex> lock(callbackMutex);
+            onDirectory(directory.string());
+        }
+
+        std::error_code iterError;
+        fs::directory_iterator it(directory, fs::directory_options::skip_permission_denied, iterError);
+        if (iterError) {
+            utils::logErr() << "Error accessing directory: " << directory.string() << " - " << iterError.message() << std::endl;
+            return;
+        }
+
+        std::vector<std::pair<fs::path, std::string>> subdirectories;
+        for (; it != fs::directory_iterator(); it.increment(iterError)) {
+            if (iterError) {
+                utils::logErr() << "Error accessing directory: " << directory.string() << " - " << iterError.message() << std::endl;
+                break;
+            }
+
+            const fs::directory_entry& entry = *it;
+            std::string name = entry.path().filename().string();
+            std::string relativePath = relativeDir.empty() ? name : relativeDir + "/" + name;
+
+            std::error_code statError;
+            if (entry.is_directory(statError)) {
+                // Символические ссылки на директории не обходятся - возможны циклы
+                if (options_.recursive && !entry.is_symlink(statError) &&
+                    !isExcluded(relativePath) && !isExcluded(relativePath + "/")) {
+                    subdirectories.emplace_back(entry.path(), relativePath);
+                }
+            } else if (entry.is_regular_file(statError) && hasExtension(name) &&
+                       isIncluded(relativePath) && !isExcluded(relativePath)) {
+                found++;
+                std::lock_guard<std::mutex> lock(callbackMutex);
+                onFile(entry.path().string(), relativePath);
+            }
+        }
+
+        for (auto& subdirectory : subdirectories) {
+            if (pool) {
+                pool->submit([&visit, subdirectory](size_t) { visit(subdirectory.first, subdirectory.second); });
+            } else {
+                visit(subdirectory.first, subdirectory.second);
+            }
+        }
+    };
+
+    if (pool) {
+        pool->submit([&](size_t) { visit(fs::path(root), relativeRoot); });
+        pool->wait();
+    } else {
+        visit(fs::path(root), relativeRoot);
+    }
+    return found;
+}
+
+std::vector<std::string> FileDiscovery::collect(const std::string& root) {
+    std::vector<std::string> files;
+    discover(root, [&files](const std::string& path, const std::string&) { files.push_back(path); });
+    std::sort(files.begin(), files.end());
+    return files;
+}
@@ -0,0 +1,61 @@
+#ifndef FILE_DISCOVERY_H
+#define FILE_DISCOVERY_H
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Настройки поиска входных файлов
+struct DiscoveryOptions {
+    std::string extension = ".fbt";    // Без учета регистра
+    std::vector<std::string> includes; // Пусто - все файлы с нужным расширением
+    std::vector<std::string> excludes; // Исключенные файлы и целые поддеревья
+    bool recursive = true;
+    int jobs = 1;                      // Потоки обхода поддиректорий
+};
+
+// Рекурсивный поиск файлов с фильтрами по маскам.
+// Маски сравниваются с путем относительно корня (разделитель '/'):
+//   *  - любые символы внутри одного компонента пути
+//   ** - любое число компонентов, в том числе ноль ("lib/**/*.fbt")
+//   ?  - один символ, кроме '/'
+// Маска без '/' сравнивается только с именем файла или директории.
+// Поддиректории при jobs > 1 обходятся параллельно, а найденные файлы сразу
+// передаются обработчику, не дожидаясь конца обхода.
+class FileDiscovery {
+public:
+    // path - путь к файлу, relativePath - путь относительно корня через '/'.
+    // Вызовы обработчика сериализуются, но могут идти из разных потоков.
+    using FileCallback = std::function<void(const std::string& path, const std::string& relativePath)>;
+    using DirectoryCallback = std::function<void(const std::string& path)>;
+
+    explicit FileDiscovery(const DiscoveryOptions& options);
+
+    // Возвращает число найденных файлов; onDirectory получает каждую обойденную директорию.
+    // relativeRoot - путь root относительно корня дерева, когда обходится его
+    // поддиректория: маски и relativePath отсчитываются от корня дерева
+    size_t discover(const std::string& root, const FileCallback& onFile,
+                    const DirectoryCallback& onDirectory = DirectoryCallback(),
+                    const std::string& relativeRoot = std::string());
+
+    // Полный отсортированный список - для вызывающих, которым не нужна потоковая выдача
+    std::vector<std::string> collect(const std::string& root);
+
+    bool isIncluded(const std::string& relativePath) const;
+    bool isExcluded(const std::string& relativePath) const;
+    // Директория или одна из ее родительских исключена - обход в нее не заходит
+    bool isDirectoryExcluded(const std::string& relativeDir) const;
+    // Файл с нужным расширением попал бы в обход: он подходит под маски,
+    // и ни одна из его директорий не исключена
+    bool isSelected(const std::string& relativePath) const;
+    bool hasExtension(const std::string& fileName) const; // Без учета регистра
+
+    static bool matchGlob(const std::string& pattern, const std::string& path);
+
+private:
+    DiscoveryOptions options_;
+    std::string extensionLower_;
+};
+
+#endif
@@ -0,0 +1,205 @@
+#include "file_watcher.h"
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    // Новые директории обходятся в потоке наблюдения
+    DiscoveryOptions watchDiscoveryOptions(const DiscoveryOptions& options) {
+        DiscoveryOptions watchOptions = options;
+        watchOptions.jobs = 1;
+        return watchOptions;
+    }
+}
+
+FileWatcher::FileWatcher(const std::string& root, const DiscoveryOptions& options, int debounceMs)
+    : root_(root), discovery_(watchDiscoveryOptions(options)), debounceMs_(debounceMs < 0 ? 0 : debounceMs), fd_(-1), rescan_(false) {
+#ifdef __linux__
+    fd_ = inotify_init1(IN_CLOEXEC);
+    if (fd_ < 0) {
+        std::cerr << "ERROR: inotify_init1 failed: " << std::strerror(errno) << std::endl;
+    }
+#endif
+}
+
+FileWatcher::~FileWatcher() {
+#ifdef __linux__
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+#endif
+}
+
+bool FileWatcher::isSupported() const {
+    return fd_ >= 0;
+}
+
+bool FileWatcher::addDirectory(const std::string& directoryPath) {
+#ifdef __linux__
+    if (fd_ < 0) {
+        return false;
+    }
+    // IN_CLOSE_WRITE вместо IN_MODIFY: файл берется, когда запись завершена
+    uint32_t mask = IN_CLOSE_WRITE | IN_CREATE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE | IN_DELETE_SELF | IN_MOVE_SELF;
+    int wd = inotify_add_watch(fd_, directoryPath.c_str(), mask);
+    if (wd < 0) {
+        std::cerr << "ERROR: Cannot watch " << directoryPath << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    watches_[wd] = directoryPath;
+    return true;
+#else
+    std::cerr << "ERROR: Watch mode is only supported on Linux" << std::endl;
+    return false;
+#endif
+}
+
+bool FileWatcher::readEvents() {
+#ifdef __linux__
+    alignas(inotify_event) char buffer[16384];
+    ssize_t length = read(fd_, buffer, sizeof(buffer));
+    if (length < 0) {
+        return errno == EINTR || errno == EAGAIN;
+    }
+
+    for (ssize_t offset = 0; offset < length;) {
+        const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+        offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+
+        if (event->mask & IN_Q_OVERFLOW) {
+            rescan_ = true;
+            continue;
+        }
+
+        auto watch = watches_.find(event->wd);
+        if (watch == watches_.end()) {
+            continue;
+        }
+
+        if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)) {
+            // Удаленная поддиректория просто выбывает из наблюдения
+            if (watches_.size() == 1) {
+                std::cerr << "ERROR: Watched directory was removed or moved" << std::endl;
+                return false;
+            }
+            if (event->mask & IN_IGNORED) {
+                watches_.erase(watch);
+            }
+            continue;
+        }
+        if (event->len == 0) {
+            continue;
+        }
+
+        std::string name = event->name;
+        if (event->mask & IN_ISDIR) {
+            std::string directoryPath = watch->second + "/" + name;
+            if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                addTree(directoryPath);
+            } else if (event->mask & IN_MOVED_FROM) {
+                removeTree(directoryPath);
+            }
+            continue;
+        }
+        if (event->mask & IN_CREATE) {
+            continue; // Файл еще пишется - дождемся IN_CLOSE_WRITE
+        }
+
+        if (!discovery_.hasExtension(name)) {
+            continue; // Временные файлы редакторов и посторонние файлы
+        }
+
+        pending_.insert(watch->second + "/" + name);
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+#ifdef __linux__
+// Файлы и поддиректории, появившиеся до установки наблюдения (cp -r, mv, mkdir -p),
+// событий уже не дадут, поэтому берутся обходом. Наблюдение ставится до чтения
+// директории, так что файл, созданный во время обхода, не теряется
+void FileWatcher::addTree(const std::string& directoryPath) {
+    std::string relativeDir = std::filesystem::path(directoryPath).lexically_relative(root_).generic_string();
+    if (discovery_.isDirectoryExcluded(relativeDir)) {
+        return; // Обход от корня в нее не заходит - наблюдать нечего
+    }
+    discovery_.discover(directoryPath,
+        [this](const std::string& path, const std::string&) {
+            pending_.insert(path);
+        },
+        [this](const std::string& directory) {
+            addDirectory(directory);
+        },
+        relativeDir);
+}
+
+// Директория ушла из дерева: наблюдения за ней и вложенными снимаются (иначе они
+// продолжили бы сообщать события по старым путям), выходные файлы удалит вызывающий
+void FileWatcher::removeTree(const std::string& directoryPath) {
+    std::string prefix = directoryPath + "/";
+    for (auto it = watches_.begin(); it != watches_.end();) {
+        if (it->second == directoryPath || it->second.compare(0, prefix.size(), prefix) == 0) {
+            inotify_rm_watch(fd_, it->first);
+            it = watches_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    removedDirectories_.insert(directoryPath);
+}
+#endif
+
+bool FileWatcher::waitForChanges(WatchChanges& changes) {
+    changes = WatchChanges();
+#ifdef __linux__
+    if (fd_ < 0 || watches_.empty()) {
+        return false;
+    }
+
+    pollfd pfd;
+    pfd.fd = fd_;
+    pfd.events = POLLIN;
+
+    while (true) {
+        // Пока изменений нет - ждем без ограничения; после первого события
+        // ждем тишины в течение debounceMs_
+        bool idle = pending_.empty() && removedDirectories_.empty() && !rescan_;
+        int timeout = idle ? -1 : debounceMs_;
+        pfd.revents = 0;
+        int ready = poll(&pfd, 1, timeout);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "ERROR: poll failed: " << std::strerror(errno) << std::endl;
+            return false;
+        }
+        if (ready == 0) {
+            break; // Тишина - отдаем накопленное
+        }
+        if (!readEvents()) {
+            return false;
+        }
+    }
+
+    changes.files.assign(pending_.begin(), pending_.end());
+    changes.removedDirectories.assign(removedDirectories_.begin(), removedDirectories_.end());
+    changes.rescan = rescan_;
+    pending_.clear();
+    removedDirectories_.clear();
+    rescan_ = false;
+    return true;
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,55 @@
+#ifndef FILE_WATCHER_H
+#define FILE_WATCHER_H
+
+#include "file_discovery.h"
+#include <set>
+#include <unordered_map>
+#include <string>
+#include <vector>
+
+// Пачка изменений, накопленных наблюдателем
+struct WatchChanges {
+    std::vector<std::string> files;              // Измененные, созданные и удаленные файлы
+    std::vector<std::string> removedDirectories; // Директории, перенесенные за пределы дерева
+    bool rescan = false; // Очередь событий ядра переполнилась, часть событий потеряна
+};
+
+// Наблюдение за директориями через inotify (только Linux).
+// События собираются в набор путей и отдаются пачкой, когда файлы
+// перестают меняться на время debounceMs: серия сохранений из редактора
+// (запись во временный файл, переименование, повторная запись) дает
+// одно обновление. Переименование сообщает и старый, и новый путь;
+// что с файлом стало в итоге, вызывающий выясняет по его наличию на диске.
+// Новые и перенесенные в дерево поддиректории добавляются в наблюдение вместе
+// со всеми вложенными, а файлы, уже лежащие в них, попадают в пачку; маски
+// --include/--exclude применяются так же, как при обходе от корня root.
+// При переполнении очереди событий вызывающий должен обойти дерево заново.
+class FileWatcher {
+public:
+    FileWatcher(const std::string& root, const DiscoveryOptions& options, int debounceMs);
+    ~FileWatcher();
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    bool isSupported() const; // false - inotify недоступен
+    bool addDirectory(const std::string& directoryPath);
+
+    // Блокируется до следующей пачки изменений; false - наблюдение прекращено
+    bool waitForChanges(WatchChanges& changes);
+
+private:
+    std::string root_;
+    FileDiscovery discovery_; // Расширение и маски - как при обходе
+    int debounceMs_;
+    int fd_;
+    std::unordered_map<int, std::string> watches_; // Дескриптор наблюдения -> директория
+    std::set<std::string> pending_;
+    std::set<std::string> removedDirectories_;
+    bool rescan_;
+
+    bool readEvents(); // Разбор доступных событий в pending_; false - ошибка или директория удалена
+    void addTree(const std::string& directoryPath);
+    void removeTree(const std::string& directoryPath);
+};
+
+#endif
@@ -0,0 +1,89 @@
+// Утилита сборки: растеризует ASCII-глифы встроенного шрифта для размеров,
+// которые использует разметка диаграммы, и записывает их исходником C++.
+// Растеризация идет через GlyphCache, поэтому результат совпадает с
+// растеризацией во время работы до бита.
+
+#include "embedded_font.h"
+#include "glyph_cache.h"
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+    // Размеры addText/getTextWidth в DiagramLayout::layout и DiagramLayout::layoutNetwork (fb_layout.cpp)
+    const int GLYPH_SIZES[] = {7, 8, 9, 12};
+    const char32_t FIRST_CODEPOINT = 0x20;
+    const char32_t LAST_CODEPOINT = 0x7E;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 2) {
+        std::cerr << "Usage: fbt_glyph_atlas <output.cpp>" << std::endl;
+        return 1;
+    }
+
+    FT_Library library;
+    FT_Face face;
+    if (FT_Init_FreeType(&library) ||
+        FT_New_Memory_Face(library, embedded_font::data, static_cast<FT_Long>(embedded_font::size), 0, &face)) {
+        std::cerr << "ERROR: Could not load embedded font " << embedded_font::name << std::endl;
+        return 1;
+    }
+
+    GlyphCache cache(face);
+    std::vector<PrebuiltGlyph> glyphs;
+    std::vector<unsigned char> bitmaps;
+    for (int size : GLYPH_SIZES) {
+        for (int italic = 0; italic <= 1; italic++) {
+            for (char32_t c = FIRST_CODEPOINT; c <= LAST_CODEPOINT; c++) {
+                const CachedGlyph& glyph = cache.getGlyph(c, size, italic != 0);
+                PrebuiltGlyph entry;
+                entry.codepoint = static_cast<uint32_t>(c);
+                entry.pixelSize = static_cast<uint16_t>(size);
+                entry.italic = static_cast<uint8_t>(italic);
+                entry.width = static_cast<int16_t>(glyph.width);
+                entry.rows = static_cast<int16_t>(glyph.rows);
+                entry.left = static_cast<int16_t>(glyph.left);
+                entry.top = static_cast<int16_t>(glyph.top);
+                entry.advance = static_cast<int16_t>(glyph.advance);
+                entry.offset = static_cast<uint32_t>(bitmaps.size());
+                glyphs.push_back(entry);
+                bitmaps.insert(bitmaps.end(), glyph.bitmap.begin(), glyph.bitmap.end());
+            }
+        }
+    }
+
+    FT_Done_Face(face);
+    FT_Done_FreeType(library);
+
+    std::ofstream out(argv[1], std::ios::binary | std::ios::trunc);
+    if (!out) {
+        std::cerr << "ERROR: Could not write " << argv[1] << std::endl;
+        return 1;
+    }
+
+    out << "// Сгенерировано fbt_glyph_atlas из " << embedded_font::name << ", не редактировать\n"
+        << "#include \"embedded_font.h\"\n\n"
+        << "namespace prebuilt_glyphs {\n"
+        << "    extern const PrebuiltGlyph glyphs[] = {\n";
+    for (const PrebuiltGlyph& g : glyphs) {
+        out << "        {" << g.codepoint << ", " << g.pixelSize << ", " << static_cast<int>(g.italic) << ", "
+            << g.width << ", " << g.rows << ", " << g.left << ", " << g.top << ", " << g.advance << ", "
+            << g.offset << "},\n";
+    }
+    out << "    };\n"
+        << "    extern const size_t count = " << glyphs.size() << ";\n"
+        << "    extern const unsigned char bitmaps[] = {";
+    for (size_t i = 0; i < bitmaps.size(); i++) {
+        out << (i % 16 == 0 ? "\n        " : "") << static_cast<int>(bitmaps[i]) << ",";
+    }
+    // Массив нулевой длины недопустим
+    out << (bitmaps.empty() ? "0" : "") << "\n    };\n}\n";
+
+    if (!out) {
+        std::cerr << "ERROR: Could not write " << argv[1] << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,173 @@
+#include "glyph_cache.h"
+#include <cstring>
+#include FT_OUTLINE_H
+
+GlyphCache::GlyphCache(FT_Face face)
+    : face_(face), hits_(0), misses_(0), currentPixelSize_(0), currentItalic_(-1) {}
+
+void GlyphCache::setFace(FT_Face face) {
+    face_ = face;
+    faceLoader_ = nullptr;
+    clear();
+}
+
+void GlyphCache::clear() {
+    glyphs_.clear();
+    hits_ = 0;
+    misses_ = 0;
+    currentPixelSize_ = 0;
+    currentItalic_ = -1;
+}
+
+void GlyphCache::preload(const PrebuiltGlyph* glyphs, size_t count, const unsigned char* bitmaps) {
+    glyphs_.reserve(glyphs_.size() + count);
+    for (size_t i = 0; i < count; i++) {
+        const PrebuiltGlyph& source = glyphs[i];
+        CachedGlyph& glyph = glyphs_[makeKey(source.codepoint, source.pixelSize, source.italic != 0, false)];
+        glyph.width = source.width;
+        glyph.rows = source.rows;
+        glyph.left = source.left;
+        glyph.top = source.top;
+        glyph.advance = source.advance;
+        glyph.hasBitmap = true;
+        const unsigned char* bitmap = bitmaps + source.offset;
+        glyph.bitmap.assign(bitmap, bitmap + static_cast<size_t>(source.width) * source.rows);
+    }
+}
+
+// Упаковка ключа в одно 64-битное число:
+// биты 0-31 - кодовая точка, 32-61 - размер, 62 - признак жирного, 63 - курсива
+uint64_t GlyphCache::makeKey(char32_t codepoint, int pixelSize, bool italic, bool bold) {
+    return static_cast<uint64_t>(codepoint) |
+           (static_cast<uint64_t>(pixelSize & 0x3FFFFFFF) << 32) |
+           (static_cast<uint64_t>(bold ? 1 : 0) << 62) |
+           (static_cast<uint64_t>(italic ? 1 : 0) << 63);
+}
+
+const CachedGlyph& GlyphCache::getGlyph(char32_t codepoint, int pixelSize, bool italic, bool bold) {
+    uint64_t key = makeKey(codepoint, pixelSize, italic, bold);
+    auto it = glyphs_.find(key);
+    if (it != glyphs_.end() && it->second.hasBitmap) {
+        hits_++;
+        return it->second;
+    }
+
+    // Промах или глиф, для которого ранее загружались только метрики
+    misses_++;
+    CachedGlyph& glyph = glyphs_[key];
+    loadGlyph(codepoint, pixelSize, italic, bold, true, glyph);
+    return glyph;
+}
+
+const CachedGlyph& GlyphCache::getMetrics(char32_t codepoint, int pixelSize, bool italic, bool bold) {
+    uint64_t key = makeKey(codepoint, pixelSize, italic, bold);
+    auto it = glyphs_.find(key);
+    if (it != glyphs_.end()) {
+        hits_++;
+        return it->second;
+    }
+
+    misses_++;
+    CachedGlyph& glyph = glyphs_[key];
+    loadGlyph(codepoint, pixelSize, italic, bold, false, glyph);
+    return glyph;
+}
+
+void GlyphCache::loadGlyph(char32_t codepoint, int pixelSize, bool italic, bool bold, bool render, CachedGlyph& glyph) {
+    // Пустой глиф считается растеризованным, чтобы не загружать его повторно
+    glyph = CachedGlyph();
+    glyph.hasBitmap = true;
+    if (!face_ && faceLoader_) {
+        face_ = faceLoader_();
+        faceLoader_ = nullptr;
+    }
+    if (!face_) {
+        return;
+    }
+
+    // Размер и матрицу меняем только при необходимости:
+    // FT_Set_Pixel_Sizes пересчитывает метрики всего шрифта
+    if (currentPixelSize_ != pixelSize) {
+        FT_Set_Pixel_Sizes(face_, 0, pixelSize);
+        currentPixelSize_ = pixelSize;
+    }
+
+    int italicState = italic ? 1 : 0;
+    if (currentItalic_ != italicState) {
+        if (italic) {
+            // Курсивный наклон
+            FT_Matrix italic_matrix;
+            italic_matrix.xx = 0x10000L;
+            italic_matrix.xy = 0x06000L;
+            italic_matrix.yx = 0x00000L;
+            italic_matrix.yy = 0x10000L;
+            FT_Set_Transform(face_, &italic_matrix, nullptr);
+        } else {
+            FT_Set_Transform(face_, nullptr, nullptr);
+        }
+        currentItalic_ = italicState;
+    }
+
+    // Жирный глиф загружается как контур, утолщается и только затем растеризуется
+    bool renderNow = render && !bold;
+    if (FT_Load_Char(face_, codepoint, renderNow ? FT_LOAD_RENDER : (bold ? FT_LOAD_NO_BITMAP : FT_LOAD_DEFAULT))) {
+        return; // Символ не загружен - остается пустой глиф
+    }
+
+    FT_GlyphSlot slot = face_->glyph;
+
+    if (bold && slot->format == FT_GLYPH_FORMAT_OUTLINE) {
+        // Утолщение на пиксель (26.6), для крупных размеров - пропорционально;
+        // метрики корректируются так же, как в FT_GlyphSlot_Embolden
+        FT_Pos strength = pixelSize > 16 ? pixelSize * 4 : 64;
+        FT_Outline_EmboldenXY(&slot->outline, strength, strength);
+        slot->metrics.width += strength;
+        slot->metrics.height += strength;
+        slot->metrics.horiBearingY += strength;
+        slot->metrics.horiAdvance += strength;
+        slot->advance.x += strength;
+    }
+
+    if (render && bold && FT_Render_Glyph(slot, FT_RENDER_MODE_NORMAL)) {
+        return;
+    }
+
+    if (!render) {
+        // Габариты по метрикам глифа (26.6), округленные наружу до пикселей
+        const FT_Glyph_Metrics& metrics = slot->metrics;
+        int left = static_cast<int>(metrics.horiBearingX >> 6);
+        int right = static_cast<int>((metrics.horiBearingX + metrics.width + 63) >> 6);
+        int top = static_cast<int>((metrics.horiBearingY + 63) >> 6);
+        int bottom = static_cast<int>((metrics.horiBearingY - metrics.height) >> 6);
+        glyph.width = right - left;
+        glyph.rows = top - bottom;
+        glyph.left = left;
+        glyph.top = top;
+        glyph.advance = static_cast<int>(slot->advance.x >> 6);
+        glyph.hasBitmap = false;
+        return;
+    }
+
+    const FT_Bitmap& bitmap = slot->bitmap;
+
+    glyph.width = static_cast<int>(bitmap.width);
+    glyph.rows = static_cast<int>(bitmap.rows);
+    glyph.left = slot->bitmap_left;
+    glyph.top = slot->bitmap_top;
+    glyph.advance = static_cast<int>(slot->advance.x >> 6);
+
+    // Копируем битмап построчно: pitch FreeType может быть больше ширины
+    glyph.bitmap.resize(static_cast<size_t>(glyph.width) * glyph.rows);
+    for (int row = 0; row < glyph.rows; ++row) {
+        std::memcpy(glyph.bitmap.data() + static_cast<size_t>(row) * glyph.width,
+                    bitmap.buffer + row * bitmap.pitch, glyph.width);
+    }
+}
+
+GlyphCacheStats GlyphCache::getStats() const {
+    GlyphCacheStats stats;
+    stats.hits = hits_;
+    stats.misses = misses_;
+    stats.entries = glyphs_.size();
+    return stats;
+}
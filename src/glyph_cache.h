@@ -0,0 +1,90 @@
+#ifndef GLYPH_CACHE_H
+#define GLYPH_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+// Растеризованный глиф вместе с метриками
+struct CachedGlyph {
+    std::vector<unsigned char> bitmap; // Маска покрытия 0-255, строки подряд (pitch == width)
+    int width = 0;   // Ширина битмапа в пикселях
+    int rows = 0;    // Высота битмапа в пикселях
+    int left = 0;    // Отступ от пера до левого края битмапа (bitmap_left)
+    int top = 0;     // Расстояние от базовой линии до верха битмапа (bitmap_top)
+    int advance = 0; // Сдвиг пера до следующего символа в пикселях
+    bool hasBitmap = false; // false - загружены только метрики, битмап пуст
+};
+
+// Глиф, растеризованный при сборке (утилита fbt_glyph_atlas) тем же кодом GlyphCache
+struct PrebuiltGlyph {
+    uint32_t codepoint;
+    uint16_t pixelSize;
+    uint8_t italic;
+    int16_t width;
+    int16_t rows;
+    int16_t left;
+    int16_t top;
+    int16_t advance;
+    uint32_t offset; // Начало маски покрытия в общем массиве битмапов
+};
+
+// Статистика обращений к кэшу глифов
+struct GlyphCacheStats {
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t entries = 0;
+};
+
+// Постоянный кэш глифов FreeType.
+// Ключ - (кодовая точка, размер в пикселях, курсив, жирный). Каждый глиф растеризуется
+// один раз за время жизни кэша и затем используется и для отрисовки, и для
+// измерения ширины текста.
+class GlyphCache {
+public:
+    explicit GlyphCache(FT_Face face = nullptr);
+
+    // Смена шрифта сбрасывает все накопленные глифы
+    void setFace(FT_Face face);
+    FT_Face getFace() const { return face_; }
+
+    // Отложенная загрузка шрифта: loader вызывается при первом промахе.
+    // Вместе с preload() позволяет отрисовать типичную диаграмму без FreeType
+    using FaceLoader = std::function<FT_Face()>;
+    void setFaceLoader(FaceLoader loader) { faceLoader_ = std::move(loader); }
+    // Есть ли шрифт - загруженный или отложенный
+    bool hasFont() const { return face_ != nullptr || faceLoader_ != nullptr; }
+
+    // Добавляет заранее растеризованные глифы; они должны быть получены из того же шрифта
+    void preload(const PrebuiltGlyph* glyphs, size_t count, const unsigned char* bitmaps);
+
+    // Возвращает глиф из кэша, при промахе растеризует его через FreeType.
+    // Если символ не удалось загрузить, возвращается пустой глиф с нулевым сдвигом.
+    // Жирное начертание получается утолщением контура перед растеризацией.
+    const CachedGlyph& getGlyph(char32_t codepoint, int pixelSize, bool italic, bool bold = false);
+    
+    // Только метрики (сдвиг и габариты) без растеризации - для векторного вывода.
+    // Если глиф уже растеризован, возвращается он же.
+    const CachedGlyph& getMetrics(char32_t codepoint, int pixelSize, bool italic, bool bold = false);
+
+    GlyphCacheStats getStats() const;
+    void clear();
+
+private:
+    FT_Face face_;
+    FaceLoader faceLoader_;
+    std::unordered_map<uint64_t, CachedGlyph> glyphs_;
+    size_t hits_;
+    size_t misses_;
+    int currentPixelSize_; // Размер, последний раз выставленный в FT_Face
+    int currentItalic_;    // Последняя выставленная матрица: -1 неизвестно, 0 нет, 1 курсив
+
+    static uint64_t makeKey(char32_t codepoint, int pixelSize, bool italic, bool bold);
+    void loadGlyph(char32_t codepoint, int pixelSize, bool italic, bool bold, bool render, CachedGlyph& glyph);
+};
+
+#endif
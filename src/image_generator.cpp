@@ -1,14 +1,52 @@
 #include "image_generator.h"
-#define STB_IMAGE_WRITE_IMPLEMENTATION
-#include "stb_image_write.h"
+#include "alpha_blend.h"
+#include "embedded_font.h"
+#include "output_writer.h"
+#include "svg_writer.h"
+#include "utils.h"
 #include <iostream>
 #include <vector>
+#include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <cstring>
+
+namespace {
+    double elapsedMs(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Строки разметки, которые может задеть элемент (с запасом для текста)
+    void itemRows(const DisplayItem& item, int& top, int& bottom) {
+        switch (item.type) {
+            case DisplayItemType::Rectangle:
+                top = item.y;
+                bottom = item.y + item.height - 1;
+                break;
+            case DisplayItemType::Line:
+                top = std::min(item.y, item.y2) - item.thickness / 2;
+                bottom = std::max(item.y, item.y2) + item.thickness / 2;
+                break;
+            case DisplayItemType::Triangle:
+            case DisplayItemType::Square:
+                top = item.y - item.size / 2;
+                bottom = item.y + item.size / 2;
+                break;
+            case DisplayItemType::Text:
+                // Базовая линия на y + fontSize/2; выносные элементы глифов не выходят за fontSize
+                top = item.y - item.fontSize;
+                bottom = item.y + item.fontSize * 2;
+                break;
+        }
+    }
+}
 
 // Конструктор - инициализация размеров изображения и FreeType
-ImageGenerator::ImageGenerator() : imageWidth_(800), imageHeight_(600), ftLibrary_(nullptr), ftFace_(nullptr) {
+ImageGenerator::ImageGenerator()
+    : imageWidth_(0), imageHeight_(0), imageStride_(0), margin_(10), scale_(1), bandRows_(256), format_(OutputFormat::Png), outputWriter_(nullptr),
+      ftLibrary_(nullptr), ftFace_(nullptr) {
     if (!initFreeType()) {
-        std::cerr << "Failed to initialize FreeType" << std::endl;
+        utils::logErr() << "Failed to initialize FreeType" << std::endl;
     }
 }
 
@@ -24,491 +62,504 @@ ImageGenerator::~ImageGenerator() {
 
 // Инициализация библиотеки FreeType и загрузка шрифта
 bool ImageGenerator::initFreeType() {
+#ifdef FBT_RENDER_EMBEDDED_FONT
+    // Встроенный шрифт: без поиска по файловой системе, результат одинаков на любой машине.
+    // FreeType загружается только при первом глифе, которого нет среди растеризованных при сборке
+    fontPath_ = std::string("embedded:") + embedded_font::name;
+    glyphCache_.setFaceLoader([this]() { return loadEmbeddedFace(); });
+#ifdef FBT_RENDER_PREBUILT_GLYPHS
+    glyphCache_.preload(prebuilt_glyphs::glyphs, prebuilt_glyphs::count, prebuilt_glyphs::bitmaps);
+#endif
+    utils::logOut() << "Using embedded font: " << embedded_font::name << std::endl;
+    return true;
+#else
     if (FT_Init_FreeType(&ftLibrary_)) {
-        std::cerr << "ERROR: Could not initialize FreeType library" << std::endl;
+        utils::logErr() << "ERROR: Could not initialize FreeType library" << std::endl;
         return false;
     }
 
-    // Список путей к шрифтам для разных операционных систем
+    // Список путей к шрифтам; пути текущей ОС проверяются первыми,
+    // чтобы не тратить время на заведомо отсутствующие файлы
     const char* fontPaths[] = {
+#if defined(_WIN32)
         "C:/Windows/Fonts/arial.ttf",
         "C:/Windows/Fonts/times.ttf",
         "C:/Windows/Fonts/calibri.ttf",
         "C:/Windows/Fonts/segoeui.ttf",
+#elif defined(__APPLE__)
+        "/Library/Fonts/Arial.ttf",
+#endif
         "/usr/share/fonts/truetype/liberation/LiberationSans-Regular.ttf",
         "/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf",
-        "/Library/Fonts/Arial.ttf",
         nullptr
     };
 
     // Попытка загрузить шрифт из списка
     for (int i = 0; fontPaths[i] != nullptr; i++) {
         if (FT_New_Face(ftLibrary_, fontPaths[i], 0, &ftFace_) == 0) {
-            std::cout << "Successfully loaded font: " << fontPaths[i] << std::endl;
+            utils::logOut() << "Successfully loaded font: " << fontPaths[i] << std::endl;
+            fontPath_ = fontPaths[i];
+            glyphCache_.setFace(ftFace_);
             return true;
         }
     }
 
-    std::cerr << "WARNING: Could not load any system font" << std::endl;
+    utils::logErr() << "WARNING: Could not load any system font" << std::endl;
     return false;
+#endif
+}
+
+// Загрузка встроенного шрифта из памяти; повторные вызовы возвращают тот же FT_Face
+FT_Face ImageGenerator::loadEmbeddedFace() {
+#ifdef FBT_RENDER_EMBEDDED_FONT
+    if (ftFace_) {
+        return ftFace_;
+    }
+    if (!ftLibrary_ && FT_Init_FreeType(&ftLibrary_)) {
+        utils::logErr() << "ERROR: Could not initialize FreeType library" << std::endl;
+        return nullptr;
+    }
+    if (FT_New_Memory_Face(ftLibrary_, embedded_font::data, static_cast<FT_Long>(embedded_font::size), 0, &ftFace_)) {
+        utils::logErr() << "ERROR: Could not load embedded font " << embedded_font::name << std::endl;
+        ftFace_ = nullptr;
+    }
+#endif
+    return ftFace_;
 }
 
-bool ImageGenerator::generateImageFromXml(const XmlNode& rootNode, const std::string& outputPath) {
-    return createFBImage(rootNode, outputPath);
+GlyphCacheStats ImageGenerator::getGlyphCacheStats() const {
+    return glyphCache_.getStats();
 }
 
-// Создание PNG изображения функционального блока
-bool ImageGenerator::createFBImage(const XmlNode& rootNode, const std::string& outputPath) {
-    std::cout << "Creating Functional Block diagram: " << outputPath << std::endl;
+RenderTimings ImageGenerator::getTimings() const {
+    return timings_;
+}
+
+// Все, от чего зависит результат при одинаковом входном файле
+std::string ImageGenerator::getFingerprint() const {
+    return "renderer=" + std::to_string(RENDERER_VERSION) +
+           ";canvas=auto;margin=" + std::to_string(margin_) +
+           ";font=" + (fontPath_.empty() ? std::string("none") : fontPath_) +
+           (format_ == OutputFormat::Svg ? std::string(";format=svg") : ";png=" + PngEncoder::describe(pngOptions_));
+}
 
-    // 1. Создаем белый фон в памяти
-    std::vector<unsigned char> image_data(imageWidth_ * imageHeight_ * 3);
-    for (size_t i = 0; i < image_data.size(); i++) {
-        image_data[i] = 255;
+bool ImageGenerator::parseOutputFormat(const std::string& text, OutputFormat& format) {
+    if (text == "png") {
+        format = OutputFormat::Png;
+    } else if (text == "svg") {
+        format = OutputFormat::Svg;
+    } else {
+        return false;
     }
+    return true;
+}
 
-    // 2. Отрисовка диаграммы функционального блока
-    drawFBDiagram(rootNode, image_data.data());
+// Создание PNG изображения функционального блока: разметка, затем растеризация
+bool ImageGenerator::generateImage(const FbInterface& fb, const std::string& outputPath) {
+    utils::logOut() << "Creating Functional Block diagram: " << outputPath << std::endl;
+    utils::logOut() << "DEBUG: Drawing FB: " << fb.name << " Version: " << fb.version << std::endl;
 
-    // 3. Сохраняем в PNG
-    bool success = stbi_write_png( // 176 Строка stb_image_write.h
-        outputPath.c_str(),     // имя файла
-        imageWidth_,           // ширина
-        imageHeight_,          // высота
-        3,                     // RGB (3 компонента)
-        image_data.data(),     // данные изображения
-        imageWidth_ * 3        // stride = ширина * 3
-    );
+    DisplayList list = layoutDiagram(fb);
+    if (format_ == OutputFormat::Svg) {
+        return writeSvg(list, outputPath);
+    }
+    return renderDisplayList(list, outputPath);
+}
+
+// Отрисовка в память - для режима сервера, где результат возвращается клиенту
+bool ImageGenerator::generateImageData(const FbInterface& fb, std::vector<unsigned char>& output) {
+    DisplayList list = layoutDiagram(fb);
+    return encodeDisplayList(list, output);
+}
+
+// Кодирование списка отображения в PNG или SVG без записи на диск
+bool ImageGenerator::encodeDisplayList(const DisplayList& list, std::vector<unsigned char>& output) {
+    output.clear();
+
+    if (format_ == OutputFormat::Svg) {
+        auto start = std::chrono::steady_clock::now();
+        std::string svg = SvgWriter(getSvgFontFamily()).render(list, margin_);
+        output.assign(svg.begin(), svg.end());
+        timings_.encodeMs += elapsedMs(start);
+        return true;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<unsigned char> image_data;
+    rasterizeCanvas(list, image_data);
+    timings_.rasterMs += elapsedMs(start);
+
+    start = std::chrono::steady_clock::now();
+    PngEncoder encoder(pngOptions_);
+    bool success = encoder.encode(image_data.data(), imageWidth_, imageHeight_, imageWidth_ * 3, output);
+    timings_.encodeMs += elapsedMs(start);
+    return success;
+}
+
+// Семейство загруженного шрифта с запасным вариантом для браузера
+std::string ImageGenerator::getSvgFontFamily() {
+    loadEmbeddedFace(); // Имя семейства есть только в самом шрифте
+    if (ftFace_ && ftFace_->family_name) {
+        return std::string(ftFace_->family_name) + ", sans-serif";
+    }
+    return "sans-serif";
+}
+
+// Векторный вывод: растровый буфер и растеризация глифов не нужны
+bool ImageGenerator::writeSvg(const DisplayList& list, const std::string& outputPath) {
+    auto start = std::chrono::steady_clock::now();
+
+    SvgWriter writer(getSvgFontFamily());
+    bool success = true;
+    if (outputWriter_) {
+        std::string svg = writer.render(list, margin_);
+        outputWriter_->write(outputPath, std::vector<unsigned char>(svg.begin(), svg.end()));
+    } else {
+        success = writer.writeFile(list, margin_, outputPath);
+    }
+
+    timings_.encodeMs += elapsedMs(start);
 
     if (success) {
-        std::cout << "Successfully created: " << outputPath << std::endl;
+        utils::logOut() << "Successfully created: " << outputPath << std::endl;
         return true;
     } else {
-        std::cerr << "Failed to create PNG: " << outputPath << std::endl;
+        utils::logErr() << "Failed to create SVG: " << outputPath << std::endl;
         return false;
     }
 }
 
-// Отрисовка текста с использованием FreeType
-void ImageGenerator::drawText(const std::string& text, unsigned char* image_data, int x, int y, 
-                              unsigned char r, unsigned char g, unsigned char b, 
-                              int fontSize, bool italic, bool bold) {
-    if (!ftFace_) {
-        return;
+// Разметка диаграммы в список отображения
+DisplayList ImageGenerator::layoutDiagram(const FbInterface& fb) {
+    auto start = std::chrono::steady_clock::now();
+
+    DiagramLayout layout(glyphCache_);
+    layout.setMetricsOnly(format_ == OutputFormat::Svg);
+    DisplayList list = layout.layout(fb);
+
+    timings_.layoutMs += elapsedMs(start);
+    return list;
+}
+
+// Разметка сети составного блока в список отображения
+DisplayList ImageGenerator::layoutNetwork(const FbInterface& fb, const TypeIndex* types) {
+    auto start = std::chrono::steady_clock::now();
+
+    DiagramLayout layout(glyphCache_);
+    layout.setMetricsOnly(format_ == OutputFormat::Svg);
+    DisplayList list = layout.layoutNetwork(fb, types);
+
+    timings_.layoutMs += elapsedMs(start);
+    return list;
+}
+
+// Размер холста - границы разметки плюс поля, умноженные на масштаб
+void ImageGenerator::getCanvasSize(const DisplayList& list, int& width, int& height) const {
+    width = (std::max(list.bounds.getWidth(), 1) + 2 * margin_) * scale_;
+    height = (std::max(list.bounds.getHeight(), 1) + 2 * margin_) * scale_;
+}
+
+// Растеризация в буфер вызывающего: белый фон, затем элементы списка
+void ImageGenerator::renderToBuffer(const DisplayList& list, unsigned char* rgb, int stride) {
+    getCanvasSize(list, imageWidth_, imageHeight_);
+    imageStride_ = stride;
+
+    for (int y = 0; y < imageHeight_; y++) {
+        std::memset(rgb + static_cast<size_t>(y) * stride, 255, static_cast<size_t>(imageWidth_) * 3);
     }
 
-    /* Устанавливам размер шрифта в пикселях (растровый размер),
-     который будет использоваться для последующего рендеринга*/
-    FT_Set_Pixel_Sizes(ftFace_, 0, fontSize);
+    // Отрисовка со сдвигом, переводящим границы разметки в поля
+    int offsetX = list.bounds.isEmpty() ? margin_ : margin_ - list.bounds.minX;
+    int offsetY = list.bounds.isEmpty() ? margin_ : margin_ - list.bounds.minY;
+    rasterize(list, rgb, offsetX, offsetY);
+}
+
+// Создание холста по границам разметки и растеризация списка
+void ImageGenerator::rasterizeCanvas(const DisplayList& list, std::vector<unsigned char>& image_data) {
+    int width = 0;
+    int height = 0;
+    getCanvasSize(list, width, height);
+    image_data.resize(static_cast<size_t>(width) * height * 3);
+    renderToBuffer(list, image_data.data(), width * 3);
+}
+
+// Растеризация списка отображения и запись PNG
+bool ImageGenerator::renderDisplayList(const DisplayList& list, const std::string& outputPath) {
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<unsigned char> image_data;
+    rasterizeCanvas(list, image_data);
 
-    // Применение курсивного наклона
-    if (italic) {
-        FT_Matrix italic_matrix;
-        italic_matrix.xx = 0x10000L;
-        italic_matrix.xy = 0x06000L;
-        italic_matrix.yx = 0x00000L;
-        italic_matrix.yy = 0x10000L;
-        FT_Set_Transform(ftFace_, &italic_matrix, nullptr);
+    timings_.rasterMs += elapsedMs(start);
+    start = std::chrono::steady_clock::now();
+
+    // 4. Сохраняем в PNG (палитра и уровень сжатия - по настройкам)
+    PngEncoder encoder(pngOptions_);
+    bool success = false;
+    if (outputWriter_) {
+        std::vector<unsigned char> png;
+        success = encoder.encode(image_data.data(), imageWidth_, imageHeight_, imageWidth_ * 3, png);
+        if (success) {
+            outputWriter_->write(outputPath, std::move(png));
+        }
     } else {
-        FT_Set_Transform(ftFace_, nullptr, nullptr);
+        success = encoder.writeFile(outputPath, image_data.data(), imageWidth_, imageHeight_, imageWidth_ * 3);
     }
 
-    // Эффект жирного шрифта через многократную отрисовку
-    if (bold) { // Если требуется жирный шрифт
-        int pen_x = x; // Начальная позиция "пера" (курсора) по горизонтали
-        
-        // Цикл по всем символам строки
-        for (size_t i = 0; i < text.length(); i++) {
-            char c = text[i]; // Текущий символ
-            
-            // Загружаем и рендерим символ в битмап
-            // FT_LOAD_RENDER означает: загрузить + сразу растеризовать
-            if (FT_Load_Char(ftFace_, c, FT_LOAD_RENDER)) {
-                continue; // Если ошибка загрузки, пропускаем этот символ
-            }
+    timings_.encodeMs += elapsedMs(start);
 
-            // Получаем указатель на растровое изображение символа
-            FT_Bitmap* bitmap = &ftFace_->glyph->bitmap;
-            
-            // Рисуем с смещениями для жирного эффекта
-            // Жирность достигается многократной отрисовкой со смещениями
-            for (int offset_x = -1; offset_x <= 1; offset_x++) { // Смещение по X: -1, 0, 1
-                for (int offset_y = -1; offset_y <= 1; offset_y++) { // Смещение по Y: -1, 0, 1
-                    if (offset_x == 0 && offset_y == 0) continue; // Пропускаем центральную позицию
-                    // Отрисовываем 8 раз вокруг центра (все комбинации кроме 0,0)
-                    
-                    // Проходим по всем строкам (пикселям по вертикали) битмапа
-                    for (unsigned int row = 0; row < bitmap->rows; ++row) {
-                        // Проходим по всем столбцам (пикселям по горизонтали) битмапа
-                        for (unsigned int col = 0; col < bitmap->width; ++col) {
-                            // Получаем значение альфа-канала (прозрачности) пикселя
-                            // pitch - количество байт от начала одной строки до начала следующей
-                            unsigned char alpha = bitmap->buffer[row * bitmap->pitch + col];
-                            
-                            // Если пиксель не полностью прозрачный
-                            if (alpha > 0) {
-                                // Вычисляем координаты пикселя на целевом изображении
-                                // pen_x - текущая позиция базовой линии
-                                // bitmap_left - левый отступ глифа (может быть отрицательным для букв типа 'j')
-                                // col - текущий столбец в битмапе
-                                // offset_x - смещение для жирности
-                                int px = pen_x + ftFace_->glyph->bitmap_left + col + offset_x;
-                                
-                                // y - базовая линия текста
-                                // bitmap_top - верхний отступ глифа (расстояние от базовой линии до верха)
-                                // row - текущая строка в битмапе
-                                // fontSize/2 - эмпирическая коррекция (автор обнаружил, что текст рисуется высоко)
-                                // offset_y - смещение для жирности
-                                int py = y - ftFace_->glyph->bitmap_top + row + fontSize / 2 + offset_y;
-                                
-                                // Проверяем, не выходит ли пиксель за границы изображения
-                                if (px >= 0 && px < imageWidth_ && py >= 0 && py < imageHeight_) {
-                                    // Вычисляем индекс в массиве image_data
-                                    // Каждый пиксель занимает 3 байта (RGB)
-                                    int index = (py * imageWidth_ + px) * 3;
-                                    
-                                    // Преобразуем альфа-значение (0-255) в коэффициент смешивания (0.0-1.0)
-                                    float blend = alpha / 255.0f;
-                                    
-                                    // Смешиваем цвет текста с существующим цветом фона (альфа-блендинг)
-                                    // Формула: новый_цвет = (1 - alpha) * старый_цвет + alpha * цвет_текста
-                                    image_data[index] = static_cast<unsigned char>(
-                                        (1 - blend) * image_data[index] + blend * r);
-                                    image_data[index + 1] = static_cast<unsigned char>(
-                                        (1 - blend) * image_data[index + 1] + blend * g);
-                                    image_data[index + 2] = static_cast<unsigned char>(
-                                        (1 - blend) * image_data[index + 2] + blend * b);
-                                }
-                            }
-                        }
-                    }
-                }
-            }
+    if (success) {
+        utils::logOut() << "Successfully created: " << outputPath << std::endl;
+        return true;
+    } else {
+        utils::logErr() << "Failed to create PNG: " << outputPath << std::endl;
+        return false;
+    }
+}
 
-            // Сдвигаем "перо" для следующего символа
-            // advance.x - расстояние до следующего символа в формате 26.6 фиксированной точки
-            // >> 6 - сдвиг вправо на 6 битов = деление на 64 (преобразование в пиксели)
-            pen_x += (ftFace_->glyph->advance.x >> 6);
-        }
+// Растеризация полосами с потоковым кодированием
+bool ImageGenerator::renderBanded(const DisplayList& list, const std::string& outputPath) {
+    int width = 0;
+    int height = 0;
+    getCanvasSize(list, width, height);
+    int bandRows = std::min(bandRows_, height);
+    size_t stride = static_cast<size_t>(width) * 3;
+    std::vector<unsigned char> band(stride * bandRows);
+
+    int offsetX = list.bounds.isEmpty() ? margin_ : margin_ - list.bounds.minX;
+    int offsetY = list.bounds.isEmpty() ? margin_ : margin_ - list.bounds.minY;
+
+    PngStreamWriter writer(pngOptions_);
+    bool success = writer.open(outputPath, width, height, outputWriter_);
+
+    // Отсечение по imageHeight_ ограничивает отрисовку строками текущей полосы
+    imageWidth_ = width;
+    imageStride_ = static_cast<int>(stride);
+    for (int top = 0; success && top < height; top += bandRows) {
+        auto start = std::chrono::steady_clock::now();
+        imageHeight_ = std::min(bandRows, height - top);
+        std::memset(band.data(), 255, stride * imageHeight_);
+        rasterize(list, band.data(), offsetX, offsetY, top);
+        timings_.rasterMs += elapsedMs(start);
+
+        start = std::chrono::steady_clock::now();
+        success = writer.writeRows(band.data(), imageHeight_, imageStride_);
+        timings_.encodeMs += elapsedMs(start);
     }
 
-    // Основная отрисовка текста (выполняется всегда, независимо от bold)
-    // Если bold=true, это центральная отрисовка поверх "тени"
-    // Если bold=false, это единственная отрисовка
-    int pen_x = x; // Начальная позиция "пера" (сбрасываем для новой отрисовки)
-    for (size_t i = 0; i < text.length(); i++) {
-        char c = text[i]; // Текущий символ
-        
-        // Загружаем и рендерим символ
-        if (FT_Load_Char(ftFace_, c, FT_LOAD_RENDER)) {
+    auto start = std::chrono::steady_clock::now();
+    success = success && writer.finish();
+    timings_.encodeMs += elapsedMs(start);
+
+    if (success) {
+        utils::logOut() << "Successfully created: " << outputPath << std::endl;
+        return true;
+    } else {
+        utils::logErr() << "Failed to create PNG: " << outputPath << std::endl;
+        return false;
+    }
+}
+
+// Отрисовка элементов списка со сдвигом (offsetX, offsetY) в единицах разметки.
+// При масштабе scale_ пиксель разметки становится квадратом scale_ x scale_,
+// а текст растеризуется шрифтом размера fontSize * scale_ со своим хинтингом.
+// Если буфер - полоса холста с верхней строкой bandTop, элементы вне нее пропускаются
+void ImageGenerator::rasterize(const DisplayList& list, unsigned char* image_data, int offsetX, int offsetY, int bandTop) {
+    int s = scale_;
+    for (const DisplayItem& item : list.items) {
+        int top = 0;
+        int bottom = 0;
+        itemRows(item, top, bottom);
+        if ((bottom + offsetY + 1) * s <= bandTop || (top + offsetY) * s >= bandTop + imageHeight_) {
             continue;
         }
 
-        // Получаем битмап символа
-        FT_Bitmap* bitmap = &ftFace_->glyph->bitmap;
-        
-        // Проходим по всем пикселям битмапа
-        for (unsigned int row = 0; row < bitmap->rows; ++row) {
-            for (unsigned int col = 0; col < bitmap->width; ++col) {
-                unsigned char alpha = bitmap->buffer[row * bitmap->pitch + col];
-                if (alpha > 0) { // Если пиксель не прозрачный
-                    // Координаты БЕЗ смещений (основная отрисовка)
-                    int px = pen_x + ftFace_->glyph->bitmap_left + col;
-                    int py = y - ftFace_->glyph->bitmap_top + row + fontSize / 2;
-                    
-                    // Проверка границ
-                    if (px >= 0 && px < imageWidth_ && py >= 0 && py < imageHeight_) {
-                        int index = (py * imageWidth_ + px) * 3;
-                        float blend = alpha / 255.0f;
-                        
-                        // Альфа-блендинг
-                        image_data[index] = static_cast<unsigned char>(
-                            (1 - blend) * image_data[index] + blend * r);
-                        image_data[index + 1] = static_cast<unsigned char>(
-                            (1 - blend) * image_data[index + 1] + blend * g);
-                        image_data[index + 2] = static_cast<unsigned char>(
-                            (1 - blend) * image_data[index + 2] + blend * b);
-                    }
+        int x = (item.x + offsetX) * s;
+        int y = (item.y + offsetY) * s - bandTop;
+        const Color& c = item.color;
+        switch (item.type) {
+            case DisplayItemType::Rectangle:
+                drawRectangle(image_data, x, y, item.width * s, item.height * s, c.r, c.g, c.b, item.fill);
+                break;
+            case DisplayItemType::Line:
+                drawLine(image_data, x, y, (item.x2 + offsetX) * s, (item.y2 + offsetY) * s - bandTop,
+                         c.r, c.g, c.b, item.thickness);
+                break;
+            case DisplayItemType::Triangle:
+                // Центр - середина масштабированного пикселя
+                blitStamp(getTriangleStamp(item.size * s, c), image_data, x + s / 2, y + s / 2);
+                break;
+            case DisplayItemType::Square:
+                if (item.size > 0) {
+                    blitStamp(getSquareStamp(item.size * s, item.fill, c), image_data,
+                              (item.x - item.size / 2 + offsetX) * s, (item.y - item.size / 2 + offsetY) * s - bandTop);
                 }
-            }
+                break;
+            case DisplayItemType::Text:
+                drawText(item.text, image_data, x, y, c.r, c.g, c.b, item.fontSize * s, item.italic, item.bold);
+                break;
         }
-
-        // Сдвигаем перо для следующего символа
-        pen_x += (ftFace_->glyph->advance.x >> 6);
     }
-
-    // Сбрасываем матрицу преобразования (курсив) в исходное состояние
-    FT_Set_Transform(ftFace_, nullptr, nullptr);
 }
-// Вычисление ширины текста в пикселях
-int ImageGenerator::getTextWidth(const std::string& text, int fontSize) {
-    if (!ftFace_) {
-        return text.length() * fontSize * 0.6;
+
+// Отрисовка текста с использованием кэша глифов FreeType
+void ImageGenerator::drawText(const std::string& text, unsigned char* image_data, int x, int y, 
+                              unsigned char r, unsigned char g, unsigned char b, 
+                              int fontSize, bool italic, bool bold) {
+    if (!glyphCache_.hasFont()) {
+        return;
     }
 
-    FT_Set_Pixel_Sizes(ftFace_, 0, fontSize);
-    
-    int width = 0;
-    for (size_t i = 0; i < text.length(); i++) {
-        char c = text[i];
-        if (FT_Load_Char(ftFace_, c, FT_LOAD_DEFAULT)) {
-            continue;
-        }
-        width += ftFace_->glyph->advance.x >> 6;
+    std::u32string codepoints = utils::decodeUtf8(text);
+
+    // Базовая линия: fontSize/2 - эмпирическая коррекция (текст рисовался высоко)
+    int baseline = y + fontSize / 2;
+    blend::BlendColor color = blend::makeBlendColor(r, g, b);
+
+    // Жирное начертание уже заложено в глифах кэша (утолщенный контур)
+    int pen_x = x; // Начальная позиция "пера" (курсора) по горизонтали
+    for (char32_t c : codepoints) {
+        const CachedGlyph& glyph = glyphCache_.getGlyph(c, fontSize, italic, bold);
+        blendGlyph(glyph, image_data, pen_x, baseline, color);
+        pen_x += glyph.advance;
     }
-    
-    return width;
 }
 
-// Отрисовка квадрата
-void ImageGenerator::drawSquare(unsigned char* image_data, int x, int y, int size,
-                               unsigned char r, unsigned char g, unsigned char b, bool fill) {
-    drawRectangle(image_data, x - size/2, y - size/2, size, size, r, g, b, fill);
-}
+// Наложение глифа на изображение: pen_x - позиция пера, baseline - базовая линия.
+// Строка глифа обрезается по холсту и смешивается целиком (см. alpha_blend.h)
+void ImageGenerator::blendGlyph(const CachedGlyph& glyph, unsigned char* image_data, int pen_x, int baseline,
+                                const blend::BlendColor& color) {
+    int left = pen_x + glyph.left;
+    int colBegin = std::max(0, -left);
+    int colEnd = std::min(glyph.width, imageWidth_ - left);
+    if (colBegin >= colEnd) {
+        return;
+    }
 
-// Отрисовка треугольника (только направленного вправо)
-void ImageGenerator::drawTriangle(unsigned char* image_data, int x, int y, int size,
-                                unsigned char r, unsigned char g, unsigned char b) {
-    for (int py = y - size/2; py <= y + size/2; py++) {
-        for (int px = x - size/2; px <= x + size/2; px++) {
-            int dx = px - x;
-            int dy = py - y;
-            // Проверка принадлежности точки треугольнику
-            if (dx >= -size/2 && dx <= size/2 && 
-                std::abs(dy) <= size/2 - std::abs(dx) && 
-                dx >= 0) {
-                if (px >= 0 && px < imageWidth_ && py >= 0 && py < imageHeight_) {
-                    int index = (py * imageWidth_ + px) * 3;
-                    image_data[index] = r;
-                    image_data[index + 1] = g;
-                    image_data[index + 2] = b;
-                }
-            }
-        }
+    for (int row = 0; row < glyph.rows; ++row) {
+        int py = baseline - glyph.top + row;
+        if (py < 0 || py >= imageHeight_) continue;
+
+        const unsigned char* coverage = glyph.bitmap.data() + static_cast<size_t>(row) * glyph.width;
+        unsigned char* dst = image_data + static_cast<size_t>(py) * imageStride_ + static_cast<size_t>(left + colBegin) * 3;
+        blend::blendCoverageRow(dst, coverage + colBegin, colEnd - colBegin, color);
     }
 }
 
-// Основная функция отрисовки диаграммы функционального блока
-void ImageGenerator::drawFBDiagram(const XmlNode& rootNode, unsigned char* image_data) {
-    std::string fbName = "Unknown";
-    auto nameIt = rootNode.attributes.find("Name");
-    if (nameIt != rootNode.attributes.end()) {
-        fbName = nameIt->second;
+// Треугольник острием вправо: точки правой половины квадрата size x size с центром
+// в точке привязки, для которых |dy| <= size/2 - dx. Каждая строка - один отрезок
+const ImageGenerator::Stamp& ImageGenerator::getTriangleStamp(int size, const Color& color) {
+    uint64_t key = (static_cast<uint64_t>(size) << 26) | (static_cast<uint64_t>(color.r) << 16) |
+                   (static_cast<uint64_t>(color.g) << 8) | color.b;
+    auto it = stamps_.find(key);
+    if (it != stamps_.end()) {
+        return it->second;
     }
 
-    std::string version = "1.0";
-    for (const auto& child : rootNode.children) {
-        if (child.name == "VersionInfo") {
-            auto versionIt = child.attributes.find("Version");
-            if (versionIt != child.attributes.end()) {
-                version = versionIt->second;
-            }
-        }
+    Stamp stamp;
+    int half = size / 2;
+    for (int dy = -half; dy <= half; dy++) {
+        stamp.spans.push_back({dy, 0, half - std::abs(dy) + 1});
+    }
+    for (int i = 0; i <= half; i++) {
+        stamp.colorRow.insert(stamp.colorRow.end(), {color.r, color.g, color.b});
     }
+    return stamps_.emplace(key, std::move(stamp)).first->second;
+}
 
-    std::cout << "DEBUG: Drawing FB: " << fbName << " Version: " << version << std::endl;
-
-    // Сбор информации о интерфейсах
-    std::vector<std::string> eventInputs;
-    std::vector<std::string> eventOutputs;
-    std::vector<std::pair<std::string, std::string>> inputVars;
-    std::vector<std::pair<std::string, std::string>> outputVars;
-    
-    // Парсинг XML для извлечения информации об интерфейсах
-    for (const auto& child : rootNode.children) {
-        if (child.name == "InterfaceList") {
-            for (const auto& interfaceChild : child.children) {
-                if (interfaceChild.name == "EventInputs") {
-                    for (const auto& event : interfaceChild.children) {
-                        if (event.name == "Event") {
-                            auto eventNameIt = event.attributes.find("Name");
-                            std::string eventName = (eventNameIt != event.attributes.end()) ? eventNameIt->second : "Unnamed";
-                            eventInputs.push_back(eventName);
-                        }
-                    }
-                } else if (interfaceChild.name == "EventOutputs") {
-                    for (const auto& event : interfaceChild.children) {
-                        if (event.name == "Event") {
-                            auto eventNameIt = event.attributes.find("Name");
-                            std::string eventName = (eventNameIt != event.attributes.end()) ? eventNameIt->second : "Unnamed";
-                            eventOutputs.push_back(eventName);
-                        }
-                    }
-                } else if (interfaceChild.name == "InputVars") {
-                    for (const auto& var : interfaceChild.children) {
-                        if (var.name == "VarDeclaration") {
-                            auto nameIt = var.attributes.find("Name");
-                            auto typeIt = var.attributes.find("Type");
-                            std::string varName = (nameIt != var.attributes.end()) ? nameIt->second : "Unnamed";
-                            std::string varType = (typeIt != var.attributes.end()) ? typeIt->second : "Unknown";
-                            inputVars.push_back({varName, varType});
-                        }
-                    }
-                } else if (interfaceChild.name == "OutputVars") {
-                    for (const auto& var : interfaceChild.children) {
-                        if (var.name == "VarDeclaration") {
-                            auto nameIt = var.attributes.find("Name");
-                            auto typeIt = var.attributes.find("Type");
-                            std::string varName = (nameIt != var.attributes.end()) ? nameIt->second : "Unnamed";
-                            std::string varType = (typeIt != var.attributes.end()) ? typeIt->second : "Unknown";
-                            outputVars.push_back({varName, varType});
-                        }
-                    }
-                }
-            }
-        }
+// Квадрат со стороной size: залитый или контур толщиной scale_, как в drawRectangle
+const ImageGenerator::Stamp& ImageGenerator::getSquareStamp(int size, bool fill, const Color& color) {
+    uint64_t key = (1ULL << 62) | (static_cast<uint64_t>(fill) << 61) | (static_cast<uint64_t>(scale_) << 42) |
+                   (static_cast<uint64_t>(size) << 26) | (static_cast<uint64_t>(color.r) << 16) |
+                   (static_cast<uint64_t>(color.g) << 8) | color.b;
+    auto it = stamps_.find(key);
+    if (it != stamps_.end()) {
+        return it->second;
     }
 
-    // Расчет размеров текста
-    int nameWidth = getTextWidth(fbName, 12);
-    int versionWidth = getTextWidth("v" + version, 8);
-    
-    // Расчет размеров основного блока
-    int maxEvents = std::max(eventInputs.size(), eventOutputs.size());
-    int maxVars = std::max(inputVars.size(), outputVars.size());
-    
-    int mainBlockWidth = std::max(200, std::max(nameWidth, versionWidth) + 40);
-    int mainBlockHeight = 80 + (maxEvents * 25) + (maxVars * 20);
-    
-    // Минимальные размеры блока
-    mainBlockWidth = std::max(mainBlockWidth, 200);
-    mainBlockHeight = std::max(mainBlockHeight, 100);
-
-    // Центрирование блока
-    int mainBlockX = (imageWidth_ - mainBlockWidth) / 2;
-    int mainBlockY = (imageHeight_ - mainBlockHeight) / 2;
-
-    // Отрисовка основного прямоугольника
-    drawRectangle(image_data, mainBlockX, mainBlockY, mainBlockWidth, mainBlockHeight, 0, 0, 0);
-    
-    // Отрисовка названия функционального блока
-    drawText(fbName, image_data, mainBlockX + mainBlockWidth/2 - nameWidth/2, 
-             mainBlockY + mainBlockHeight/2 - 8, 0, 0, 0, 12, true);
-    
-    // Отрисовка версии
-    drawText("v" + version, image_data, mainBlockX + mainBlockWidth/2 - versionWidth/2, 
-             mainBlockY + mainBlockHeight/2 + 8, 0, 0, 0, 8, false);
-
-    // Координата для квадратиков слева
-    int squareX = mainBlockX - 15;
-
-    // Отрисовка входных событий (левая сторона)
-    int eventInputY = mainBlockY + 25;
-    for (size_t i = 0; i < eventInputs.size(); i++) {
-        int currentY = eventInputY + i * 22;
-        
-        // Квадратик
-        drawSquare(image_data, squareX, currentY, 8, 0, 0, 0, false);
-        
-        // Линия от квадратика к блоку
-        drawLine(image_data, squareX, currentY, mainBlockX, currentY, 0, 0, 0, 1);
-        
-        // Линия наружу
-        drawLine(image_data, mainBlockX - 30, currentY, squareX, currentY, 0, 0, 0, 1);
-        
-        // Зеленый треугольник для первой линии
-        if (i == 0) {
-            drawTriangle(image_data, mainBlockX, currentY, 10, 0, 255, 0);
+    Stamp stamp;
+    int border = scale_;
+    for (int row = 0; row < size; row++) {
+        if (fill || row < border || row >= size - border) {
+            stamp.spans.push_back({row, 0, size});
+        } else {
+            stamp.spans.push_back({row, 0, std::min(border, size)});
+            stamp.spans.push_back({row, std::max(size - border, 0), std::min(border, size)});
         }
-        
-        // Текст "Event"
-        drawText("Event", image_data, mainBlockX - 70, currentY - 4, 0, 0, 0, 8, false);
-        
-        // Название события
-        drawText(eventInputs[i], image_data, mainBlockX + 8, currentY - 4, 0, 0, 0, 9, false);
     }
+    for (int i = 0; i < size; i++) {
+        stamp.colorRow.insert(stamp.colorRow.end(), {color.r, color.g, color.b});
+    }
+    return stamps_.emplace(key, std::move(stamp)).first->second;
+}
 
-    // Отрисовка выходных событий (правая сторона)
-    int eventOutputY = mainBlockY + 25;
-    for (size_t i = 0; i < eventOutputs.size(); i++) {
-        int currentY = eventOutputY + i * 22;
-        
-        // Зеленый треугольник для первой линии
-        if (i == 0) {
-            drawTriangle(image_data, mainBlockX + mainBlockWidth - 5, currentY, 10, 0, 255, 0);
+// Вывод штампа в точку (x, y): по одному memcpy на отрезок, с отсечением по холсту
+void ImageGenerator::blitStamp(const Stamp& stamp, unsigned char* image_data, int x, int y) {
+    for (const Stamp::Span& span : stamp.spans) {
+        int py = y + span.row;
+        if (py < 0 || py >= imageHeight_) {
+            continue;
         }
-        
-        // Линия наружу
-        drawLine(image_data, mainBlockX + mainBlockWidth, currentY, mainBlockX + mainBlockWidth + 30, currentY, 0, 0, 0, 1);
-        
-        // Текст "Event"
-        drawText("Event", image_data, mainBlockX + mainBlockWidth + 35, currentY - 4, 0, 0, 0, 8, false);
-        
-        // Название события
-        drawText(eventOutputs[i], image_data, mainBlockX + mainBlockWidth - 40, currentY - 4, 0, 0, 0, 9, false);
+        int x0 = std::max(x + span.col, 0);
+        int x1 = std::min(x + span.col + span.length, imageWidth_);
+        if (x0 >= x1) {
+            continue;
+        }
+        std::memcpy(image_data + static_cast<size_t>(py) * imageStride_ + static_cast<size_t>(x0) * 3,
+                    stamp.colorRow.data() + static_cast<size_t>(x0 - x - span.col) * 3,
+                    static_cast<size_t>(x1 - x0) * 3);
     }
+}
 
-    // Отрисовка входных переменных (левая сторона)
-    int inputStartY = mainBlockY + mainBlockHeight/2 + 20;
-    for (size_t i = 0; i < inputVars.size(); i++) {
-        int yPos = inputStartY + i * 18;
-        
-        // Квадратик
-        drawSquare(image_data, squareX, yPos, 8, 0, 0, 0, false);
-        
-        // Линия от квадратика к блоку
-        drawLine(image_data, squareX, yPos, mainBlockX, yPos, 0, 0, 0, 1);
-        
-        // Линия наружу
-        drawLine(image_data, mainBlockX - 45, yPos, squareX, yPos, 0, 0, 0, 1);
-        
-        // Синий треугольник
-        drawTriangle(image_data, mainBlockX, yPos, 8, 0, 0, 255);
-        
-        // Имя переменной
-        drawText(inputVars[i].first, image_data, mainBlockX + 8, yPos - 4, 0, 0, 0, 9, false);
-        
-        // Тип переменной
-        drawText(inputVars[i].second, image_data, mainBlockX - 110, yPos - 4, 0, 0, 0, 7, false);
+// Заливка прямоугольника с однократным отсечением по холсту.
+// Первая строка заполняется удвоением уже записанных пикселей, остальные - копией первой.
+void ImageGenerator::fillRect(unsigned char* image_data, int x, int y, int width, int height,
+                              unsigned char r, unsigned char g, unsigned char b) {
+    int x0 = std::max(x, 0);
+    int y0 = std::max(y, 0);
+    int x1 = std::min(x + width, imageWidth_);
+    int y1 = std::min(y + height, imageHeight_);
+    if (x0 >= x1 || y0 >= y1) {
+        return;
     }
 
-    // Отрисовка выходных переменных (правая сторона)
-    int outputStartY = mainBlockY + mainBlockHeight/2 + 20;
-    for (size_t i = 0; i < outputVars.size(); i++) {
-        int yPos = outputStartY + i * 18;
-        
-        // Синий треугольник
-        drawTriangle(image_data, mainBlockX + mainBlockWidth - 5, yPos, 8, 0, 0, 255);
-        
-        // Линия наружу
-        drawLine(image_data, mainBlockX + mainBlockWidth, yPos, mainBlockX + mainBlockWidth + 45, yPos, 0, 0, 0, 1);
-        
-        // Имя переменной
-        drawText(outputVars[i].first, image_data, mainBlockX + mainBlockWidth - 40, yPos - 4, 0, 0, 0, 9, false);
-        
-        // Тип переменной
-        drawText(outputVars[i].second, image_data, mainBlockX + mainBlockWidth + 50, yPos - 4, 0, 0, 0, 7, false);
-    }
+    size_t stride = static_cast<size_t>(imageStride_);
+    size_t spanBytes = static_cast<size_t>(x1 - x0) * 3;
+    unsigned char* first = image_data + y0 * stride + static_cast<size_t>(x0) * 3;
 
-    // Отрисовка вертикальной линии, соединяющей квадратики
-    if (!eventInputs.empty() || !inputVars.empty()) {
-        int firstLineY = 0;
-        int lastLineY = 0;
-        
-        // Определение первой линии
-        if (!eventInputs.empty()) {
-            firstLineY = mainBlockY + 25;
-        } else if (!inputVars.empty()) {
-            firstLineY = mainBlockY + mainBlockHeight/2 + 20;
-        }
-        
-        // Определение последней линии
-        if (!inputVars.empty()) {
-            lastLineY = mainBlockY + mainBlockHeight/2 + 20 + (inputVars.size() - 1) * 18;
-        } else if (!eventInputs.empty()) {
-            lastLineY = mainBlockY + 25 + (eventInputs.size() - 1) * 22;
-        }
-        
-        // Отрисовка вертикальной линии
-        if (firstLineY > 0 && lastLineY > 0 && firstLineY != lastLineY) {
-            drawLine(image_data, squareX, firstLineY, squareX, lastLineY, 0, 0, 0, 1);
+    if (r == g && g == b) {
+        std::memset(first, r, spanBytes);
+    } else {
+        first[0] = r;
+        first[1] = g;
+        first[2] = b;
+        size_t filled = 3;
+        while (filled < spanBytes) {
+            size_t chunk = std::min(filled, spanBytes - filled);
+            std::memcpy(first + filled, first, chunk);
+            filled += chunk;
         }
     }
+
+    for (int py = y0 + 1; py < y1; py++) {
+        std::memcpy(image_data + py * stride + static_cast<size_t>(x0) * 3, first, spanBytes);
+    }
 }
 
-// Отрисовка линии алгоритмом Брезенхэма
+// Отрисовка линии: горизонтальные и вертикальные - заливкой полосы,
+// остальные - алгоритмом Брезенхэма
 void ImageGenerator::drawLine(unsigned char* image_data, int x1, int y1, int x2, int y2, 
                               unsigned char r, unsigned char g, unsigned char b, int thickness) {
+    // Толщина задана в пикселях разметки: каждый из них - квадрат scale_ x scale_
+    int half = (thickness / 2) * scale_;
+    int span = 2 * half + scale_; // Ширина линии на холсте
+    if (y1 == y2 || x1 == x2) {
+        int left = std::min(x1, x2) - half;
+        int top = std::min(y1, y2) - half;
+        fillRect(image_data, left, top, std::abs(x2 - x1) + span, std::abs(y2 - y1) + span, r, g, b);
+        return;
+    }
+
     int dx = std::abs(x2 - x1);
     int dy = std::abs(y2 - y1);
     int sx = (x1 < x2) ? 1 : -1;
@@ -517,12 +568,12 @@ void ImageGenerator::drawLine(unsigned char* image_data, int x1, int y1, int x2,
 
     while (true) {
         // Отрисовка пикселей с учетом толщины
-        for (int tx = -thickness/2; tx <= thickness/2; tx++) {
-            for (int ty = -thickness/2; ty <= thickness/2; ty++) {
+        for (int tx = -half; tx < span - half; tx++) {
+            for (int ty = -half; ty < span - half; ty++) {
                 int px = x1 + tx;
                 int py = y1 + ty;
                 if (px >= 0 && px < imageWidth_ && py >= 0 && py < imageHeight_) {
-                    int index = (py * imageWidth_ + px) * 3;
+                    size_t index = static_cast<size_t>(py) * imageStride_ + static_cast<size_t>(px) * 3;
                     image_data[index] = r;
                     image_data[index + 1] = g;
                     image_data[index + 2] = b;
@@ -548,50 +599,22 @@ void ImageGenerator::drawLine(unsigned char* image_data, int x1, int y1, int x2,
 // Отрисовка прямоугольника
 void ImageGenerator::drawRectangle(unsigned char* image_data, int x, int y, int width, int height,
                                   unsigned char r, unsigned char g, unsigned char b, bool fill) {
+    if (width <= 0 || height <= 0) {
+        return;
+    }
+
     if (fill) {
         // Заливка прямоугольника
-        for (int py = y; py < y + height; py++) {
-            for (int px = x; px < x + width; px++) {
-                if (px >= 0 && px < imageWidth_ && py >= 0 && py < imageHeight_) {
-                    int index = (py * imageWidth_ + px) * 3;
-                    image_data[index] = r;
-                    image_data[index + 1] = g;
-                    image_data[index + 2] = b;
-                }
-            }
-        }
+        fillRect(image_data, x, y, width, height, r, g, b);
     } else {
-        // Отрисовка контура
+        // Отрисовка контура толщиной в один пиксель разметки
+        int border = scale_;
         // Верхняя и нижняя границы
-        for (int px = x; px < x + width; px++) {
-            if (px >= 0 && px < imageWidth_ && y >= 0 && y < imageHeight_) {
-                int index = (y * imageWidth_ + px) * 3;
-                image_data[index] = r;
-                image_data[index + 1] = g;
-                image_data[index + 2] = b;
-            }
-            if (px >= 0 && px < imageWidth_ && (y + height - 1) >= 0 && (y + height - 1) < imageHeight_) {
-                int index = ((y + height - 1) * imageWidth_ + px) * 3;
-                image_data[index] = r;
-                image_data[index + 1] = g;
-                image_data[index + 2] = b;
-            }
-        }
+        fillRect(image_data, x, y, width, border, r, g, b);
+        fillRect(image_data, x, y + height - border, width, border, r, g, b);
         
         // Левая и правая границы
-        for (int py = y; py < y + height; py++) {
-            if (x >= 0 && x < imageWidth_ && py >= 0 && py < imageHeight_) {
-                int index = (py * imageWidth_ + x) * 3;
-                image_data[index] = r;
-                image_data[index + 1] = g;
-                image_data[index + 2] = b;
-            }
-            if ((x + width - 1) >= 0 && (x + width - 1) < imageWidth_ && py >= 0 && py < imageHeight_) {
-                int index = (py * imageWidth_ + (x + width - 1)) * 3;
-                image_data[index] = r;
-                image_data[index + 1] = g;
-                image_data[index + 2] = b;
-            }
-        }
+        fillRect(image_data, x, y, border, height, r, g, b);
+        fillRect(image_data, x + width - border, y, border, height, r, g, b);
     }
-}
\ No newline at end of file
+}
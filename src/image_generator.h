@@ -1,42 +1,129 @@
 #ifndef IMAGE_GENERATOR_H
 #define IMAGE_GENERATOR_H
 
-#include "xml_parser.h"
+#include "alpha_blend.h"
+#include "fb_interface.h"
+#include "fb_layout.h"
+#include "glyph_cache.h"
+#include "png_encoder.h"
+#include <cstdint>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include <utility>
 #include <ft2build.h>
 #include FT_FREETYPE_H
 
+// Формат выходного файла
+enum class OutputFormat {
+    Png,
+    Svg  // Векторный вывод: без растеризации, FreeType только для метрик текста
+};
+
+// Суммарное время стадий отрисовки
+struct RenderTimings {
+    double layoutMs = 0;
+    double rasterMs = 0;
+    double encodeMs = 0; // Кодирование PNG или SVG и запись файла (без записи, если она асинхронная)
+};
+
+class OutputWriter;
+
 class ImageGenerator {
 public:
+    // Версия алгоритма отрисовки; увеличивается при любом изменении выходных изображений
+    static const int RENDERER_VERSION = 6;
     
     ImageGenerator();
     ~ImageGenerator();
     
-    bool generateImageFromXml(const XmlNode& rootNode, const std::string& outputPath);
+    bool generateImage(const FbInterface& fb, const std::string& outputPath);
+    // То же без записи на диск: в output помещаются байты PNG или текст SVG
+    bool generateImageData(const FbInterface& fb, std::vector<unsigned char>& output);
+    
+    // Стадии по отдельности: разметку можно сохранить и растеризовать повторно
+    DisplayList layoutDiagram(const FbInterface& fb);
+    DisplayList layoutNetwork(const FbInterface& fb, const TypeIndex* types = nullptr); // Сеть составного блока (см. DiagramLayout)
+    bool renderDisplayList(const DisplayList& list, const std::string& outputPath);
+    bool writeSvg(const DisplayList& list, const std::string& outputPath);
+    // Растеризация полосами по getBandRows() строк с потоковой записью PNG:
+    // в памяти одновременно только одна полоса, а не все изображение.
+    // Палитра не строится, файл всегда 24-битный RGB.
+    bool renderBanded(const DisplayList& list, const std::string& outputPath);
+    bool encodeDisplayList(const DisplayList& list, std::vector<unsigned char>& output);
+    
+    // Растеризация в буфер вызывающего (RGB, 3 байта на пиксель, stride байт в строке).
+    // Буфер должен вмещать холст размера getCanvasSize.
+    void getCanvasSize(const DisplayList& list, int& width, int& height) const;
+    void renderToBuffer(const DisplayList& list, unsigned char* rgb, int stride);
+    
+    GlyphCacheStats getGlyphCacheStats() const; // Статистика кэша глифов
+    RenderTimings getTimings() const; // Время разметки, растеризации и кодирования
+    std::string getFingerprint() const; // Версия и настройки генератора для инкрементальной сборки
+    void setPngOptions(const PngOptions& options) { pngOptions_ = options; } // Настройки кодирования PNG
+    void setMargin(int margin) { margin_ = margin < 0 ? 0 : margin; } // Поля вокруг диаграммы в пикселях
+    // Целый масштаб растеризации (1 - как в разметке); разметка от него не зависит
+    void setScale(int scale) { scale_ = scale < 1 ? 1 : scale; }
+    int getScale() const { return scale_; }
+    void setBandRows(int rows) { bandRows_ = rows < 1 ? 1 : rows; } // Высота полосы для renderBanded
+    int getBandRows() const { return bandRows_; }
+    void setOutputFormat(OutputFormat format) { format_ = format; }
+    // Запись файлов через очередь OutputWriter вместо записи в этом потоке;
+    // ошибки записи сообщает его flush(). nullptr - обычная запись
+    void setOutputWriter(OutputWriter* writer) { outputWriter_ = writer; }
+    
+    static bool parseOutputFormat(const std::string& text, OutputFormat& format);
     
 private:
-    int imageWidth_;
+    int imageWidth_;  // Размер текущего изображения, вычисляется по разметке диаграммы
     int imageHeight_;
+    int imageStride_; // Байт в строке буфера, в который идет растеризация
+    int margin_;
+    int scale_;
+    int bandRows_;
+    OutputFormat format_;
+    OutputWriter* outputWriter_;
     FT_Library ftLibrary_;
     FT_Face ftFace_;
+    std::string fontPath_;
+    PngOptions pngOptions_;
+    GlyphCache glyphCache_; // Кэш растеризованных глифов, общий для отрисовки и измерения текста
+    RenderTimings timings_;
+    
+    // Заранее растеризованное украшение вывода (треугольник или квадрат):
+    // закрашенные отрезки строк относительно точки привязки и строка цвета,
+    // из которой отрезки копируются в изображение
+    struct Stamp {
+        struct Span {
+            int row;
+            int col;
+            int length;
+        };
+        std::vector<Span> spans;
+        std::vector<unsigned char> colorRow; // Длина самого длинного отрезка, 3 байта на пиксель
+    };
+    std::unordered_map<uint64_t, Stamp> stamps_; // По форме, размеру, масштабу и цвету
     
     bool initFreeType(); // Инициализация шрифта
-    bool createFBImage(const XmlNode& rootNode, const std::string& outputPath); // Создание изображения
-    void drawFBDiagram(const XmlNode& rootNode, unsigned char* image_data); // Отрисовка диаграммы
+    FT_Face loadEmbeddedFace(); // Отложенная загрузка встроенного шрифта
+    std::string getSvgFontFamily();
+    void rasterizeCanvas(const DisplayList& list, std::vector<unsigned char>& image_data); // Холст с отрисованным списком
+    // Растеризация списка; bandTop - строка холста, с которой начинается буфер
+    void rasterize(const DisplayList& list, unsigned char* image_data, int offsetX, int offsetY, int bandTop = 0);
     void drawText(const std::string& text, unsigned char* image_data, int x, int y, 
                   unsigned char r, unsigned char g, unsigned char b, 
                   int fontSize = 10, bool italic = false, bool bold = false); // Отрисовка текста
+    void blendGlyph(const CachedGlyph& glyph, unsigned char* image_data, int pen_x, int baseline,
+                    const blend::BlendColor& color); // Наложение глифа на изображение
     void drawLine(unsigned char* image_data, int x1, int y1, int x2, int y2, 
                   unsigned char r, unsigned char g, unsigned char b, int thickness = 1); // Отрисовка линий
     void drawRectangle(unsigned char* image_data, int x, int y, int width, int height,
                       unsigned char r, unsigned char g, unsigned char b, bool fill = false); // Отрисовка прямоугольника
-    void drawSquare(unsigned char* image_data, int x, int y, int size,
-                   unsigned char r, unsigned char g, unsigned char b, bool fill = false); // Отрисовка квадрата
-    void drawTriangle(unsigned char* image_data, int x, int y, int size,
-                     unsigned char r, unsigned char g, unsigned char b); // Отрисовка треугольника
-    int getTextWidth(const std::string& text, int fontSize); // Ширина текста
+    const Stamp& getTriangleStamp(int size, const Color& color); // Треугольник острием вправо, привязка - центр
+    const Stamp& getSquareStamp(int size, bool fill, const Color& color); // Квадрат, привязка - левый верхний угол
+    void blitStamp(const Stamp& stamp, unsigned char* image_data, int x, int y); // Копирование с отсечением
+    void fillRect(unsigned char* image_data, int x, int y, int width, int height,
+                  unsigned char r, unsigned char g, unsigned char b); // Заливка с отсечением по холсту
 };
 
 #endif
\ No newline at end of file
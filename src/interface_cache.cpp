@@ -0,0 +1,383 @@
+#include "interface_cache.h"
+#include "utils.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+// Формат (все числа в порядке байт машины, которая писала файл):
+//   заголовок: "FBTCACHE", версия формата u32, метка порядка байт u32,
+//              число записей u64, смещение индекса u64
+//   записи:    интерфейсы подряд, строки - длина u32 и байты
+//   индекс:    (хеш u64, смещение u64, размер u64) по возрастанию хеша
+// Смещения и размеры выровнены на 8 байт, чтобы индекс читался прямо из отображения.
+namespace {
+    const char CACHE_MAGIC[8] = {'F', 'B', 'T', 'C', 'A', 'C', 'H', 'E'};
+    const uint32_t BYTE_ORDER_MARK = 0x01020304;
+    const size_t HEADER_SIZE = 32;
+
+    struct CacheHeader {
+        char magic[8];
+        uint32_t formatVersion;
+        uint32_t byteOrder;
+        uint64_t entryCount;
+        uint64_t indexOffset;
+    };
+    static_assert(sizeof(CacheHeader) == HEADER_SIZE, "unexpected cache header layout");
+
+    class RecordWriter {
+    public:
+        explicit RecordWriter(std::vector<unsigned char>& out) : out_(out) {}
+
+        void u32(uint32_t value) { append(&value, sizeof(value)); }
+        void f64(double value) { append(&value, sizeof(value)); }
+        void str(const std::string& value) {
+            u32(static_cast<uint32_t>(value.size()));
+            append(value.data(), value.size());
+        }
+
+    private:
+        std::vector<unsigned char>& out_;
+
+        void append(const void* data, size_t size) {
+            const unsigned char* bytes = static_cast<const unsigned char*>(data);
+            out_.insert(out_.end(), bytes, bytes + size);
+        }
+    };
+
+    // Чтение с проверкой границ: при выходе за запись ok() становится false
+    class RecordReader {
+    public:
+        RecordReader(const unsigned char* data, size_t size) : pos_(data), end_(data + size) {}
+
+        bool ok() const { return ok_; }
+
+        uint32_t u32() {
+            uint32_t value = 0;
+            read(&value, sizeof(value));
+            return value;
+        }
+        double f64() {
+            double value = 0;
+            read(&value, sizeof(value));
+            return value;
+        }
+        std::string str() {
+            uint32_t size = u32();
+            if (!ok_ || size > static_cast<size_t>(end_ - pos_)) {
+                ok_ = false;
+                return std::string();
+            }
+            std::string value(reinterpret_cast<const char*>(pos_), size);
+            pos_ += size;
+            return value;
+        }
+        // Число элементов списка; каждый занимает не меньше minSize байт
+        size_t count(size_t minSize) {
+            uint32_t value = u32();
+            if (!ok_ || value > static_cast<size_t>(end_ - pos_) / minSize) {
+                ok_ = false;
+                return 0;
+            }
+            return value;
+        }
+
+    private:
+        const unsigned char* pos_;
+        const unsigned char* end_;
+        bool ok_ = true;
+
+        void read(void* value, size_t size) {
+            if (!ok_ || size > static_cast<size_t>(end_ - pos_)) {
+                ok_ = false;
+                return;
+            }
+            std::memcpy(value, pos_, size);
+            pos_ += size;
+        }
+    };
+
+    void encodeInterface(const FbInterface& fb, std::vector<unsigned char>& out) {
+        RecordWriter writer(out);
+        writer.str(fb.name);
+        writer.str(fb.comment);
+        writer.str(fb.version);
+        writer.str(fb.packageName);
+
+        for (const std::vector<FbEvent>* events : {&fb.eventInputs, &fb.eventOutputs}) {
+            writer.u32(static_cast<uint32_t>(events->size()));
+            for (const FbEvent& event : *events) {
+                writer.str(event.name);
+                writer.str(event.type);
+                writer.str(event.comment);
+                writer.u32(static_cast<uint32_t>(event.with.size()));
+                for (const std::string& with : event.with) {
+                    writer.str(with);
+                }
+            }
+        }
+
+        for (const std::vector<FbVar>* vars : {&fb.inputVars, &fb.outputVars}) {
+            writer.u32(static_cast<uint32_t>(vars->size()));
+            for (const FbVar& var : *vars) {
+                writer.str(var.name);
+                writer.str(var.type);
+                writer.str(var.comment);
+                writer.str(var.arraySize);
+                writer.str(var.initialValue);
+            }
+        }
+
+        writer.u32(static_cast<uint32_t>(fb.network.instances.size()));
+        for (const FbInstance& instance : fb.network.instances) {
+            writer.str(instance.name);
+            writer.str(instance.type);
+            writer.f64(instance.x);
+            writer.f64(instance.y);
+        }
+        writer.u32(static_cast<uint32_t>(fb.network.connections.size()));
+        for (const FbConnection& connection : fb.network.connections) {
+            writer.str(connection.source);
+            writer.str(connection.destination);
+            writer.u32(static_cast<uint32_t>(connection.kind));
+        }
+    }
+
+    bool decodeInterface(const unsigned char* data, size_t size, FbInterface& fb) {
+        RecordReader reader(data, size);
+        fb = FbInterface();
+        fb.name = reader.str();
+        fb.comment = reader.str();
+        fb.version = reader.str();
+        fb.packageName = reader.str();
+
+        for (std::vector<FbEvent>* events : {&fb.eventInputs, &fb.eventOutputs}) {
+            events->resize(reader.count(16));
+            for (FbEvent& event : *events) {
+                event.name = reader.str();
+                event.type = reader.str();
+                event.comment = reader.str();
+                event.with.resize(reader.count(4));
+                for (std::string& with : event.with) {
+                    with = reader.str();
+                }
+            }
+        }
+
+        for (std::vector<FbVar>* vars : {&fb.inputVars, &fb.outputVars}) {
+            vars->resize(reader.count(20));
+            for (FbVar& var : *vars) {
+                var.name = reader.str();
+                var.type = reader.str();
+                var.comment = reader.str();
+                var.arraySize = reader.str();
+                var.initialValue = reader.str();
+            }
+        }
+
+        fb.network.instances.resize(reader.count(24));
+        for (FbInstance& instance : fb.network.instances) {
+            instance.name = reader.str();
+            instance.type = reader.str();
+            instance.x = reader.f64();
+            instance.y = reader.f64();
+        }
+        fb.network.connections.resize(reader.count(12));
+        for (FbConnection& connection : fb.network.connections) {
+            connection.source = reader.str();
+            connection.destination = reader.str();
+            uint32_t kind = reader.u32();
+            if (kind > static_cast<uint32_t>(FbConnectionKind::Adapter)) {
+                return false;
+            }
+            connection.kind = static_cast<FbConnectionKind>(kind);
+        }
+
+        return reader.ok();
+    }
+
+    size_t alignTo8(size_t value) {
+        return (value + 7) & ~static_cast<size_t>(7);
+    }
+}
+
+const char* InterfaceCache::FILE_NAME = ".fbt_to_png.cache";
+// Увеличивается при любом изменении FbInterface, разбора XML или формата записи
+const uint32_t InterfaceCache::FORMAT_VERSION = 1;
+
+bool InterfaceCache::load(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    file_.close();
+    index_ = nullptr;
+    indexSize_ = 0;
+    added_.clear();
+    used_.clear();
+
+    if (!utils::fileExists(path) || !file_.open(path)) {
+        return false;
+    }
+
+    CacheHeader header;
+    if (file_.size() < HEADER_SIZE) {
+        file_.close();
+        return false;
+    }
+    std::memcpy(&header, file_.data(), HEADER_SIZE);
+
+    bool valid = std::memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) == 0 &&
+                 header.formatVersion == FORMAT_VERSION && header.byteOrder == BYTE_ORDER_MARK &&
+                 header.indexOffset % 8 == 0 && header.indexOffset <= file_.size() &&
+                 header.entryCount == (file_.size() - header.indexOffset) / sizeof(IndexEntry) &&
+                 (file_.size() - header.indexOffset) % sizeof(IndexEntry) == 0;
+    if (!valid) {
+        // Другая версия формата или обрезанный файл: кэш будет перестроен
+        file_.close();
+        return false;
+    }
+
+    index_ = reinterpret_cast<const IndexEntry*>(file_.data() + header.indexOffset);
+    indexSize_ = static_cast<size_t>(header.entryCount);
+    for (size_t i = 0; i < indexSize_; i++) {
+        const IndexEntry& entry = index_[i];
+        if (entry.offset < HEADER_SIZE || entry.offset > header.indexOffset ||
+            entry.size > header.indexOffset - entry.offset ||
+            (i > 0 && index_[i - 1].contentHash >= entry.contentHash)) {
+            file_.close();
+            index_ = nullptr;
+            indexSize_ = 0;
+            return false;
+        }
+    }
+    return true;
+}
+
+const InterfaceCache::IndexEntry* InterfaceCache::findEntry(uint64_t contentHash) const {
+    const IndexEntry* end = index_ + indexSize_;
+    const IndexEntry* it = std::lower_bound(index_, end, contentHash,
+        [](const IndexEntry& entry, uint64_t hash) { return entry.contentHash < hash; });
+    return it != end && it->contentHash == contentHash ? it : nullptr;
+}
+
+bool InterfaceCache::find(uint64_t contentHash, FbInterface& fb) {
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto added = added_.find(contentHash);
+        if (added != added_.end()) {
+            data = added->second.data();
+            size = added->second.size();
+        } else if (const IndexEntry* entry = findEntry(contentHash)) {
+            data = reinterpret_cast<const unsigned char*>(file_.data()) + entry->offset;
+            size = static_cast<size_t>(entry->size);
+        }
+        if (!data) {
+            misses_++;
+            return false;
+        }
+    }
+
+    // Записи не меняются до save(), так что декодировать можно без блокировки.
+    // Поврежденная запись не попадет в следующий файл: вместо нее сохранится новая
+    bool decoded = decodeInterface(data, size, fb);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!decoded) {
+        misses_++;
+        return false;
+    }
+    hits_++;
+    used_.insert(contentHash);
+    return true;
+}
+
+void InterfaceCache::store(uint64_t contentHash, const FbInterface& fb) {
+    std::vector<unsigned char> record;
+    encodeInterface(fb, record);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    added_.emplace(contentHash, std::move(record));
+}
+
+void InterfaceCache::retain(uint64_t contentHash) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (findEntry(contentHash)) {
+        used_.insert(contentHash);
+    }
+}
+
+bool InterfaceCache::save(const std::string& path) {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    // Записи по возрастанию хеша: новые и использованные из старого файла
+    std::map<uint64_t, std::pair<const unsigned char*, size_t>> records;
+    for (uint64_t hash : used_) {
+        const IndexEntry* entry = findEntry(hash);
+        if (entry) {
+            records[hash] = {reinterpret_cast<const unsigned char*>(file_.data()) + entry->offset,
+                             static_cast<size_t>(entry->size)};
+        }
+    }
+    for (const auto& record : added_) {
+        records[record.first] = {record.second.data(), record.second.size()};
+    }
+
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            utils::logErr() << "ERROR: Could not write interface cache: " << tempPath << std::endl;
+            return false;
+        }
+
+        std::vector<IndexEntry> index;
+        index.reserve(records.size());
+        static const char padding[8] = {};
+        size_t offset = HEADER_SIZE;
+        out.seekp(static_cast<std::streamoff>(HEADER_SIZE));
+        for (const auto& record : records) {
+            index.push_back({record.first, offset, record.second.second});
+            out.write(reinterpret_cast<const char*>(record.second.first), static_cast<std::streamsize>(record.second.second));
+            size_t aligned = alignTo8(offset + record.second.second);
+            out.write(padding, static_cast<std::streamsize>(aligned - offset - record.second.second));
+            offset = aligned;
+        }
+        out.write(reinterpret_cast<const char*>(index.data()), static_cast<std::streamsize>(index.size() * sizeof(IndexEntry)));
+
+        CacheHeader header;
+        std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+        header.formatVersion = FORMAT_VERSION;
+        header.byteOrder = BYTE_ORDER_MARK;
+        header.entryCount = index.size();
+        header.indexOffset = offset;
+        out.seekp(0);
+        out.write(reinterpret_cast<const char*>(&header), HEADER_SIZE);
+
+        if (!out) {
+            utils::logErr() << "ERROR: Could not write interface cache: " << tempPath << std::endl;
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tempPath, path, ec);
+    if (ec) {
+        utils::logErr() << "ERROR: Could not replace interface cache " << path << ": " << ec.message() << std::endl;
+        std::filesystem::remove(tempPath, ec);
+        return false;
+    }
+
+    // Дальше (режим наблюдения) работаем с только что записанным файлом
+    lock.unlock();
+    load(path);
+    return true;
+}
+
+InterfaceCacheStats InterfaceCache::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    InterfaceCacheStats stats;
+    stats.hits = hits_;
+    stats.misses = misses_;
+    stats.entries = indexSize_;
+    return stats;
+}
@@ -0,0 +1,66 @@
+#ifndef INTERFACE_CACHE_H
+#define INTERFACE_CACHE_H
+
+#include "fb_interface.h"
+#include "mapped_file.h"
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+// Статистика обращений к кэшу интерфейсов
+struct InterfaceCacheStats {
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t entries = 0; // Записи, загруженные из файла
+};
+
+// Кэш разобранных интерфейсов FB на диске, ключ - хеш содержимого .fbt.
+// Файл кэша отображается в память и читается без копирования: по отсортированному
+// индексу в конце файла запись находится двоичным поиском и декодируется
+// прямо в FbInterface, без XML. Новые записи копятся в памяти и пишутся в save().
+// При смене FORMAT_VERSION (любое изменение FbInterface или разбора) или
+// поврежденном файле кэш считается пустым; измененный файл получает новый хеш.
+// find/store/retain потокобезопасны.
+class InterfaceCache {
+public:
+    static const char* FILE_NAME;
+    static const uint32_t FORMAT_VERSION;
+
+    // Отображение файла кэша; отсутствующий, устаревший или поврежденный файл дает пустой кэш
+    bool load(const std::string& path);
+    // Атомарная запись через временный файл. Сохраняются только записи, использованные
+    // с момента load() (find, store, retain), - кэш не растет за счет удаленных файлов
+    bool save(const std::string& path);
+
+    bool find(uint64_t contentHash, FbInterface& fb);
+    void store(uint64_t contentHash, const FbInterface& fb);
+    // Запись нужна и дальше, хотя файл в этом запуске не разбирался (пропущен инкрементальной сборкой)
+    void retain(uint64_t contentHash);
+
+    InterfaceCacheStats getStats() const;
+
+private:
+    struct IndexEntry {
+        uint64_t contentHash;
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    const IndexEntry* findEntry(uint64_t contentHash) const;
+
+    MappedFile file_;
+    const IndexEntry* index_ = nullptr; // Внутри file_
+    size_t indexSize_ = 0;
+
+    mutable std::mutex mutex_;
+    std::map<uint64_t, std::vector<unsigned char>> added_; // Новые записи в двоичном виде
+    std::set<uint64_t> used_;                              // Использованные записи файла
+    size_t hits_ = 0;
+    size_t misses_ = 0;
+};
+
+#endif
@@ -1,10 +1,39 @@
+#include <iomanip>
 #include <iostream>
+#include <sstream>
 #include <string>
-#include "xml_parser.h"
-#include "image_generator.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <thread>
+#include "atlas_builder.h"
+#include "batch_converter.h"
+#include "file_discovery.h"
+#include "file_watcher.h"
+#include "render_server.h"
 #include "utils.h"
 #include <argparse/argparse.hpp>
 
+namespace {
+    // Список масштабов "1,2,3": целые от 1 до 8, повторы отбрасываются
+    bool parseScales(const std::string& text, std::vector<int>& scales) {
+        scales.clear();
+        std::stringstream stream(text);
+        std::string item;
+        while (std::getline(stream, item, ',')) {
+            if (item.size() != 1 || item[0] < '1' || item[0] > '8') {
+                return false;
+            }
+            int scale = item[0] - '0';
+            if (std::find(scales.begin(), scales.end(), scale) == scales.end()) {
+                scales.push_back(scale);
+            }
+        }
+        std::sort(scales.begin(), scales.end());
+        return !scales.empty();
+    }
+}
+
 int main(int argc, char* argv[]) {
     // 1. Создаем парсер аргументов командной строки
     argparse::ArgumentParser program("fbt_to_png", "1.0");
@@ -14,7 +43,7 @@ int main(int argc, char* argv[]) {
     
     // 3. Добавляем аргументы
     program.add_argument("-i", "--input")
-        .help("директория с входными .fbt файлами (по умолчанию: xml)")
+        .help("директория с входными .fbt файлами, обходится рекурсивно (по умолчанию: xml)")
         .default_value(std::string("xml"))
         .metavar("DIR");
     
@@ -22,6 +51,108 @@ int main(int argc, char* argv[]) {
         .help("директория для выходных .png файлов (по умолчанию: xml_png)")
         .default_value(std::string("xml_png"))
         .metavar("DIR");
+    
+    program.add_argument("-j", "--jobs")
+        .help("число потоков преобразования (0 - по числу ядер, по умолчанию: 1)")
+        .default_value(1)
+        .scan<'i', int>()
+        .metavar("N");
+    
+    program.add_argument("--include")
+        .help("обрабатывать только файлы, подходящие под маску (можно указать несколько раз; поддерживаются *, ** и ?)")
+        .default_value(std::vector<std::string>())
+        .append()
+        .metavar("GLOB");
+    
+    program.add_argument("--exclude")
+        .help("пропускать файлы и директории, подходящие под маску (можно указать несколько раз)")
+        .default_value(std::vector<std::string>())
+        .append()
+        .metavar("GLOB");
+    
+    program.add_argument("--incremental")
+        .help("пропускать файлы, не изменившиеся с прошлого запуска (манифест в выходной директории)")
+        .default_value(false)
+        .implicit_value(true);
+    
+    program.add_argument("--no-cache")
+        .help("не использовать кэш разобранных интерфейсов в выходной директории")
+        .default_value(false)
+        .implicit_value(true);
+    
+    program.add_argument("--sync-write")
+        .help("писать файлы в рабочих потоках, без отдельного потока записи")
+        .default_value(false)
+        .implicit_value(true);
+    
+    program.add_argument("--watch")
+        .help("после преобразования следить за входной директорией и перерисовывать измененные файлы")
+        .default_value(false)
+        .implicit_value(true);
+    
+    program.add_argument("--debounce")
+        .help("пауза после последнего изменения перед перерисовкой в режиме --watch, мс (по умолчанию: 150)")
+        .default_value(150)
+        .scan<'i', int>()
+        .metavar("MS");
+    
+    program.add_argument("--serve")
+        .help("режим сервера: запросы из stdin, ответы в stdout (шрифт загружается один раз)")
+        .default_value(false)
+        .implicit_value(true);
+    
+    program.add_argument("--socket")
+        .help("режим сервера на Unix-сокете по указанному пути")
+        .default_value(std::string(""))
+        .metavar("PATH");
+    
+    program.add_argument("-f", "--format")
+        .help("формат выходных файлов: png или svg (по умолчанию: png)")
+        .default_value(std::string("png"))
+        .metavar("FORMAT");
+    
+    program.add_argument("--margin")
+        .help("поля вокруг диаграммы в пикселях (по умолчанию: 10)")
+        .default_value(10)
+        .scan<'i', int>()
+        .metavar("PX");
+    
+    program.add_argument("--scales")
+        .help("масштабы PNG через запятую, например 1,2,3: NAME.png, NAME@2x.png, NAME@3x.png (по умолчанию: 1)")
+        .default_value(std::string("1"))
+        .metavar("LIST");
+    
+    program.add_argument("--atlas")
+        .help("собрать все блоки в атлас NAME_N.png с индексом NAME.json вместо отдельных файлов")
+        .default_value(std::string(""))
+        .metavar("NAME");
+    
+    program.add_argument("--atlas-size")
+        .help("наибольшая сторона страницы атласа в пикселях (по умолчанию: 2048)")
+        .default_value(2048)
+        .scan<'i', int>()
+        .metavar("PX");
+    
+    program.add_argument("--atlas-padding")
+        .help("зазор между блоками в атласе в пикселях (по умолчанию: 1)")
+        .default_value(1)
+        .scan<'i', int>()
+        .metavar("PX");
+    
+    program.add_argument("--png-level")
+        .help("уровень сжатия PNG: 0-9, fast, default или max (по умолчанию: default)")
+        .default_value(std::string("default"))
+        .metavar("LEVEL");
+    
+    program.add_argument("--png-filter")
+        .help("фильтрация строк PNG: none, sub, up, average, paeth или adaptive (по умолчанию: adaptive)")
+        .default_value(std::string("adaptive"))
+        .metavar("FILTER");
+    
+    program.add_argument("--png-color")
+        .help("цветовой режим PNG: auto (палитра, если цветов не больше 256), palette или rgb (по умолчанию: auto)")
+        .default_value(std::string("auto"))
+        .metavar("MODE");
 
     try {
         // 4. Парсим аргументы командной строки
@@ -35,87 +166,224 @@ int main(int argc, char* argv[]) {
     
     std::string inputDir = program.get<std::string>("--input");
     std::string outputDir = program.get<std::string>("--output");
+    int jobs = program.get<int>("--jobs");
+    if (jobs <= 0) {
+        jobs = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    }
+    
+    ConverterOptions options;
+    options.outputDir = outputDir;
+    options.incremental = program.get<bool>("--incremental");
+    options.interfaceCache = !program.get<bool>("--no-cache");
+    options.asyncWrite = !program.get<bool>("--sync-write");
+    options.margin = program.get<int>("--margin");
+    
+    if (!PngEncoder::parseCompressionLevel(program.get<std::string>("--png-level"), options.png.compressionLevel) ||
+        !PngEncoder::parseFilter(program.get<std::string>("--png-filter"), options.png.filter) ||
+        !PngEncoder::parseColorMode(program.get<std::string>("--png-color"), options.png.colorMode) ||
+        !ImageGenerator::parseOutputFormat(program.get<std::string>("--format"), options.format)) {
+        std::cerr << "ERROR: Invalid output format options" << std::endl;
+        std::cerr << program << std::endl;
+        return 1;
+    }
+    
+    if (!parseScales(program.get<std::string>("--scales"), options.scales)) {
+        std::cerr << "ERROR: Invalid scales (expected a list like 1,2,3 with values 1-8)" << std::endl;
+        return 1;
+    }
+    if (options.scales != std::vector<int>{1} && options.format != OutputFormat::Png) {
+        std::cerr << "ERROR: --scales applies only to PNG output" << std::endl;
+        return 1;
+    }
+    
+    // Режим сервера: без поиска файлов и пакетной сводки
+    std::string socketPath = program.get<std::string>("--socket");
+    if (program.get<bool>("--serve") || !socketPath.empty()) {
+        RenderServer server(options);
+        return socketPath.empty() ? server.serveStdio() : server.serveSocket(socketPath);
+    }
     
     std::cout << "FBT to PNG Converter" << std::endl;
     std::cout << "====================" << std::endl;
     
-    // Пробуем несколько возможных путей
-    std::vector<std::string> possibleInputDirs = {
-        "../" + inputDir,
-        "./" + inputDir, 
-        inputDir,
-        "."
-    };
-    
-    std::string foundInputDir;
-    std::vector<std::string> files;
-    
-    // Ищем директорию с файлами
-    for (const auto& dir : possibleInputDirs) {
-        std::cout << "Checking directory: " << dir << std::endl;
-        auto foundFiles = utils::getFilesInDirectory(dir, ".fbt");
-        if (!foundFiles.empty()) {
-            files = foundFiles;
-            foundInputDir = dir;
-            break;
-        }
+    if (!std::filesystem::is_directory(inputDir)) {
+        std::cerr << "ERROR: Input directory does not exist: " << inputDir << std::endl;
+        std::cerr << "Укажите правильную директорию с помощью --input" << std::endl;
+        return 1;
     }
     
     // Создаем выходную директорию
     utils::createDirectoryIfNotExists(outputDir);
     
-    if (files.empty()) {
-        std::cerr << "ERROR: No .fbt files found in any of the expected directories!" << std::endl;
-        std::cerr << "Please make sure your .fbt files are in one of these locations:" << std::endl;
-        for (const auto& dir : possibleInputDirs) {
-            std::cerr << "  - " << dir << std::endl;
+    if (jobs > 1) {
+        std::cout << "Using " << jobs << " worker threads" << std::endl;
+    }
+    
+    DiscoveryOptions discoveryOptions;
+    discoveryOptions.includes = program.get<std::vector<std::string>>("--include");
+    discoveryOptions.excludes = program.get<std::vector<std::string>>("--exclude");
+    discoveryOptions.jobs = jobs;
+    FileDiscovery discovery(discoveryOptions);
+    
+    // Режим атласа: все блоки упаковываются в общие страницы
+    std::string atlasName = program.get<std::string>("--atlas");
+    if (!atlasName.empty()) {
+        if (options.format != OutputFormat::Png) {
+            std::cerr << "ERROR: Atlas output supports only PNG" << std::endl;
+            return 1;
         }
-        std::cerr << "\nИли укажите правильную директорию с помощью --input" << std::endl;
+        AtlasOptions atlasOptions;
+        atlasOptions.outputDir = outputDir;
+        atlasOptions.name = atlasName;
+        atlasOptions.maxSize = std::max(1, program.get<int>("--atlas-size"));
+        atlasOptions.padding = program.get<int>("--atlas-padding");
+        // Блоки в атласе по умолчанию без полей: их задает зазор
+        atlasOptions.margin = program.is_used("--margin") ? options.margin : 0;
+        atlasOptions.jobs = jobs;
+        atlasOptions.png = options.png;
+        
+        AtlasBuilder atlas(atlasOptions);
+        size_t fileCount = discovery.discover(inputDir,
+            [&atlas](const std::string& path, const std::string& relativePath) {
+                atlas.add(path, relativePath);
+            });
+        if (fileCount == 0) {
+            std::cerr << "ERROR: No .fbt files found in " << inputDir << std::endl;
+            return 1;
+        }
+        AtlasSummary summary = atlas.build();
+        
+        std::cout << "\n=== Atlas Summary ===" << std::endl;
+        std::cout << "Blocks: " << summary.blockCount << std::endl;
+        std::cout << "Errors: " << summary.errorCount << std::endl;
+        std::cout << "Pages: " << summary.pageCount << std::endl;
+        std::cout << std::fixed << std::setprecision(1)
+                  << "Stage time: layout " << summary.timings.layoutMs << " ms, raster "
+                  << summary.timings.rasterMs << " ms, encode " << summary.timings.encodeMs << " ms" << std::endl;
+        return (summary.errorCount > 0) ? 1 : 0;
+    }
+    
+    // Наблюдение включается до обхода, чтобы не пропустить изменения во время первой сборки
+    bool watch = program.get<bool>("--watch");
+    FileWatcher watcher(inputDir, discoveryOptions, program.get<int>("--debounce"));
+    if (watch && !watcher.isSupported()) {
+        return 1;
+    }
+    
+    // Индекс типов для рамок экземпляров в сетях составных блоков.
+    // Заполняется тем же обходом, но без фильтров --include/--exclude: исключенный
+    // из отрисовки тип все равно может встречаться в сетях. Поэтому обход заходит и
+    // в исключенные директории, а фильтры применяются к найденным файлам
+    DiscoveryOptions typeDiscoveryOptions = discoveryOptions;
+    typeDiscoveryOptions.includes.clear();
+    typeDiscoveryOptions.excludes.clear();
+    FileDiscovery typeDiscovery(typeDiscoveryOptions);
+    options.types = std::make_shared<TypeIndex>();
+    
+    // Файлы уходят на преобразование по мере обнаружения
+    options.jobs = jobs;
+    BatchConverter converter(options);
+    auto convertTree = [&](bool addWatches) {
+        options.types->clear();
+        converter.begin();
+        size_t count = 0;
+        typeDiscovery.discover(inputDir,
+            [&](const std::string& path, const std::string& relativePath) {
+                options.types->add(path);
+                if (discovery.isSelected(relativePath)) {
+                    converter.submit(path, relativePath);
+                    count++;
+                }
+            },
+            [&](const std::string& directory) {
+                std::string relativeDir = std::filesystem::path(directory).lexically_relative(inputDir).generic_string();
+                if (addWatches && !discovery.isDirectoryExcluded(relativeDir == "." ? std::string() : relativeDir)) {
+                    watcher.addDirectory(directory);
+                }
+            });
+        return count;
+    };
+    size_t fileCount = convertTree(watch);
+    ConversionSummary summary = converter.finish();
+    
+    if (fileCount == 0) {
+        std::cerr << "ERROR: No .fbt files found in " << inputDir << std::endl;
         return 1;
     }
     
-    std::cout << "Found " << files.size() << " .fbt files in: " << foundInputDir << std::endl;
-    for (const auto& file : files) {
-        std::cout << "  - " << file << std::endl;
+    std::cout << "\n=== Conversion Summary ===" << std::endl;
+    std::cout << "Success: " << summary.successCount << " files" << std::endl;
+    std::cout << "Errors: " << summary.errorCount << " files" << std::endl;
+    if (options.incremental) {
+        std::cout << "Up to date: " << summary.skippedCount << " files" << std::endl;
+        std::cout << "Removed orphaned: " << summary.removedCount << " files" << std::endl;
     }
+    std::cout << "Total: " << fileCount << " files found in " << inputDir << std::endl;
+    std::cout << "Output directory: " << outputDir << std::endl;
     
-    XmlParser parser;
-    ImageGenerator generator;
+    const GlyphCacheStats& glyphStats = summary.glyphStats;
+    size_t glyphLookups = glyphStats.hits + glyphStats.misses;
+    std::cout << "Glyph cache: " << glyphStats.hits << " hits, " << glyphStats.misses << " misses ("
+              << (glyphLookups > 0 ? glyphStats.hits * 100 / glyphLookups : 0) << "% hit rate, "
+              << glyphStats.entries << " glyphs)" << std::endl;
+    const InterfaceCacheStats& cacheStats = summary.cacheStats;
+    if (options.interfaceCache) {
+        std::cout << "Interface cache: " << cacheStats.hits << " hits, " << cacheStats.misses << " misses ("
+                  << cacheStats.entries << " entries)" << std::endl;
+    }
+    const OutputWriterStats& writerStats = summary.writerStats;
+    if (options.asyncWrite) {
+        std::cout << "Output writer: " << writerStats.files << " files, " << writerStats.bytes / 1024 << " KB, "
+                  << writerStats.stalls << " stalls (" << (writerStats.ioUring ? "io_uring" : "thread") << ")" << std::endl;
+    }
+    const TypeIndexStats& typeStats = summary.typeStats;
+    if (typeStats.hits + typeStats.misses + typeStats.unresolved > 0) {
+        std::cout << "Type index: " << typeStats.types << " types, " << typeStats.hits << " hits, "
+                  << typeStats.misses << " misses, " << typeStats.unresolved << " unresolved" << std::endl;
+    }
+    std::cout << std::fixed << std::setprecision(1)
+              << "Stage time: layout " << summary.timings.layoutMs << " ms, raster "
+              << summary.timings.rasterMs << " ms, encode " << summary.timings.encodeMs << " ms" << std::endl;
     
-    int successCount = 0;
-    int errorCount = 0;
+    if (!watch) {
+        return (summary.errorCount > 0) ? 1 : 0;
+    }
     
-    for (const auto& file : files) {
-        std::cout << "\nProcessing: " << file << std::endl;
-        
-        if (!utils::fileExists(file)) {
-            std::cerr << "File does not exist: " << file << std::endl;
-            errorCount++;
+    // Режим наблюдения: генератор и шрифт остаются загруженными между событиями
+    std::cout << "\nWatching " << inputDir << " for changes (Ctrl+C to stop)" << std::endl;
+    
+    WatchChanges changes;
+    while (watcher.waitForChanges(changes)) {
+        if (changes.rescan) {
+            // Часть событий потеряна: повторяем полную сборку, как при запуске
+            std::cout << "Watch event queue overflowed, rescanning " << inputDir << std::endl;
+            convertTree(true);
+            ConversionSummary rescanSummary = converter.finish();
+            std::cout << "Rescanned: " << rescanSummary.successCount << " converted, "
+                      << rescanSummary.errorCount << " errors" << std::endl;
             continue;
         }
         
-        if (parser.parseFile(file)) {
-            std::string baseName = utils::getFileNameWithoutExtension(file);
-            std::string outputFile = outputDir + "/" + baseName + ".png";
-            
-            if (generator.generateImageFromXml(parser.getRootNode(), outputFile)) {
-                std::cout << "[OK] Created: " << outputFile << std::endl;
-                successCount++;
-            } else {
-                std::cerr << "[ERROR] Failed to create image for: " << file << std::endl;
-                errorCount++;
+        for (const auto& directory : changes.removedDirectories) {
+            std::string relativePath = std::filesystem::path(directory).lexically_relative(inputDir).generic_string();
+            if (!discovery.isDirectoryExcluded(relativePath)) {
+                converter.removeDirectory(relativePath);
+            }
+        }
+        for (const auto& file : changes.files) {
+            std::string relativePath = std::filesystem::path(file).lexically_relative(inputDir).generic_string();
+            // Те же фильтры, что при обходе, включая исключенные директории на пути к файлу
+            if (!discovery.isSelected(relativePath)) {
+                continue;
+            }
+            bool exists = utils::fileExists(file);
+            auto start = std::chrono::steady_clock::now();
+            bool ok = converter.updateFile(file, relativePath);
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            if (exists) {
+                std::cout << (ok ? "Updated " : "Failed to update ") << file << " in " << ms << " ms" << std::endl;
             }
-        } else {
-            std::cerr << "[ERROR] Failed to parse: " << file << std::endl;
-            errorCount++;
         }
     }
-    
-    std::cout << "\n=== Conversion Summary ===" << std::endl;
-    std::cout << "Success: " << successCount << " files" << std::endl;
-    std::cout << "Errors: " << errorCount << " files" << std::endl;
-    std::cout << "Total: " << files.size() << " files processed" << std::endl;
-    std::cout << "Output directory: " << outputDir << std::endl;
-    
-    return (errorCount > 0) ? 1 : 0;
+    return 1;
 }
\ No newline at end of file
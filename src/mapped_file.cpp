@@ -0,0 +1,68 @@
+#include "mapped_file.h"
+#include <fstream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const std::string& filePath) {
+    close();
+
+#ifndef _WIN32
+    int fd = ::open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+        ::close(fd);
+        return false;
+    }
+    size_ = static_cast<size_t>(info.st_size);
+    if (size_ > 0) {
+        void* address = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if (address != MAP_FAILED) {
+            data_ = static_cast<char*>(address);
+            mapped_ = true;
+        }
+    }
+    ::close(fd);
+    if (mapped_ || size_ == 0) {
+        return true;
+    }
+#endif
+
+    // Отображение недоступно - обычное чтение
+    std::ifstream in(filePath, std::ios::binary | std::ios::ate);
+    if (!in) {
+        return false;
+    }
+    buffer_.resize(static_cast<size_t>(in.tellg()));
+    in.seekg(0);
+    if (!in.read(buffer_.data(), static_cast<std::streamsize>(buffer_.size()))) {
+        buffer_.clear();
+        return false;
+    }
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+    return true;
+}
+
+void MappedFile::close() {
+#ifndef _WIN32
+    if (mapped_) {
+        munmap(data_, size_);
+    }
+#endif
+    mapped_ = false;
+    data_ = nullptr;
+    size_ = 0;
+    buffer_.clear();
+}
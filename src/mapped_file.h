@@ -0,0 +1,32 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Файл, отображенный в память для разбора на месте.
+// Отображение частное (copy-on-write): парсер может изменять буфер,
+// файл на диске при этом не меняется. Без mmap (Windows) файл читается в память.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Закрывает предыдущее отображение; false - файл не удалось открыть
+    bool open(const std::string& filePath);
+    void close();
+
+    char* data() { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    char* data_ = nullptr;
+    size_t size_ = 0;
+    bool mapped_ = false;
+    std::vector<char> buffer_; // Запасной вариант, если отображение недоступно
+};
+
+#endif
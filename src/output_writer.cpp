@@ -0,0 +1,477 @@
+#include "output_writer.h"
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+
+#if defined(FBT_RENDER_IO_URING) && defined(__linux__)
+#define FBT_OUTPUT_IO_URING
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Больше этого в очереди не держим: десятки обычных PNG или несколько полос сети
+const size_t OutputWriter::DEFAULT_QUEUE_BYTES = 64 * 1024 * 1024;
+
+struct OutputWriter::OpenFile {
+    std::string path;
+    std::ofstream out;   // Обычная запись
+    int fd = -1;         // Запись через io_uring
+    uint64_t offset = 0; // Смещение следующей порции при записи через io_uring
+    size_t inFlight = 0; // Порции, отправленные в io_uring и еще не завершенные
+    bool closing = false;
+    bool failed = false;
+    bool discarded = false;
+};
+
+#ifdef FBT_OUTPUT_IO_URING
+
+namespace {
+
+// Поток записи один, поэтому глубокая очередь не нужна: нескольких операций
+// в полете хватает, чтобы диск не простаивал между порциями
+const unsigned RING_ENTRIES = 16;
+
+// Длина одной операции - 32 бита; большие порции пишутся в несколько заходов
+const size_t MAX_WRITE_SIZE = size_t(1) << 30;
+
+}
+
+// Кольца io_uring без liburing: очереди отправки и завершения отображаются из ядра.
+// Каждая операция записи владеет своим слотом, номер слота - user_data
+struct OutputWriter::Ring {
+    struct Slot {
+        FileId file = 0;
+        int fd = -1;
+        std::vector<unsigned char> data;
+        size_t written = 0;
+        uint64_t offset = 0; // Смещение data[0] в файле
+    };
+
+    int fd = -1;
+    void* sqMap = MAP_FAILED;
+    size_t sqMapSize = 0;
+    void* cqMap = MAP_FAILED;
+    size_t cqMapSize = 0;
+    void* sqeMap = MAP_FAILED;
+    size_t sqeMapSize = 0;
+
+    unsigned* sqTail = nullptr;
+    unsigned sqMask = 0;
+    unsigned* sqArray = nullptr;
+    io_uring_sqe* sqes = nullptr;
+    unsigned* cqHead = nullptr;
+    unsigned* cqTail = nullptr;
+    unsigned cqMask = 0;
+    io_uring_cqe* cqes = nullptr;
+    unsigned toSubmit = 0;
+
+    std::vector<Slot> slots;
+    std::vector<size_t> freeSlots;
+    size_t inFlight = 0;
+
+    ~Ring() {
+        if (sqeMap != MAP_FAILED) {
+            munmap(sqeMap, sqeMapSize);
+        }
+        if (cqMap != MAP_FAILED && cqMap != sqMap) {
+            munmap(cqMap, cqMapSize);
+        }
+        if (sqMap != MAP_FAILED) {
+            munmap(sqMap, sqMapSize);
+        }
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+
+    bool init() {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        fd = static_cast<int>(syscall(__NR_io_uring_setup, RING_ENTRIES, &params));
+        // IORING_OP_WRITE появилась в том же ядре (5.6), что и этот признак
+        if (fd < 0 || !(params.features & IORING_FEAT_RW_CUR_POS)) {
+            return false;
+        }
+
+        sqMapSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqMapSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (singleMap) {
+            sqMapSize = cqMapSize = std::max(sqMapSize, cqMapSize);
+        }
+        sqMap = mmap(nullptr, sqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        if (sqMap == MAP_FAILED) {
+            return false;
+        }
+        cqMap = singleMap ? sqMap
+                          : mmap(nullptr, cqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (cqMap == MAP_FAILED) {
+            return false;
+        }
+        sqeMapSize = params.sq_entries * sizeof(io_uring_sqe);
+        sqeMap = mmap(nullptr, sqeMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+        if (sqeMap == MAP_FAILED) {
+            return false;
+        }
+
+        char* sq = static_cast<char*>(sqMap);
+        sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        sqes = static_cast<io_uring_sqe*>(sqeMap);
+        char* cq = static_cast<char*>(cqMap);
+        cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+        slots.resize(RING_ENTRIES);
+        for (size_t i = RING_ENTRIES; i-- > 0;) {
+            freeSlots.push_back(i);
+        }
+        return true;
+    }
+
+    // Ставит в очередь отправки запись оставшейся части слота. Слотов не больше,
+    // чем мест в очереди, а enter() отправляет все сразу, поэтому место всегда есть
+    void push(size_t index) {
+        Slot& slot = slots[index];
+        unsigned tail = *sqTail;
+        unsigned position = tail & sqMask;
+        io_uring_sqe& sqe = sqes[position];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = IORING_OP_WRITE;
+        sqe.fd = slot.fd;
+        sqe.addr = reinterpret_cast<uint64_t>(slot.data.data() + slot.written);
+        sqe.len = static_cast<uint32_t>(std::min(slot.data.size() - slot.written, MAX_WRITE_SIZE));
+        sqe.off = slot.offset + slot.written;
+        sqe.user_data = index;
+        sqArray[position] = position;
+        __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+        toSubmit++;
+    }
+
+    // Отправка поставленных записей и, при minComplete > 0, ожидание завершений
+    bool enter(unsigned minComplete) {
+        for (;;) {
+            long result = syscall(__NR_io_uring_enter, fd, toSubmit, minComplete,
+                                  minComplete > 0 ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+            if (result >= 0) {
+                toSubmit -= static_cast<unsigned>(result);
+                return true;
+            }
+            if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+                return false;
+            }
+        }
+    }
+
+    bool pop(uint64_t& userData, int& result) {
+        unsigned head = *cqHead;
+        if (head == __atomic_load_n(cqTail, __ATOMIC_ACQUIRE)) {
+            return false;
+        }
+        const io_uring_cqe& cqe = cqes[head & cqMask];
+        userData = cqe.user_data;
+        result = cqe.res;
+        __atomic_store_n(cqHead, head + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+};
+
+#else
+
+// Без io_uring кольцо никогда не создается
+struct OutputWriter::Ring {
+    size_t inFlight = 0;
+};
+
+#endif
+
+OutputWriter::OutputWriter(size_t maxQueuedBytes) : maxQueuedBytes_(maxQueuedBytes) {
+#ifdef FBT_OUTPUT_IO_URING
+    // Ядро без io_uring или с запретом его вызовов - обычная запись
+    ring_ = std::make_unique<Ring>();
+    if (!ring_->init()) {
+        ring_.reset();
+    }
+#endif
+    stats_.ioUring = ring_ != nullptr;
+    thread_ = std::thread(&OutputWriter::run, this);
+}
+
+OutputWriter::~OutputWriter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    operationReady_.notify_one();
+    thread_.join();
+}
+
+OutputWriter::FileId OutputWriter::open(const std::string& path) {
+    FileId file;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        file = nextFile_++;
+    }
+    Operation operation;
+    operation.kind = Operation::Open;
+    operation.file = file;
+    operation.path = path;
+    enqueue(std::move(operation));
+    return file;
+}
+
+void OutputWriter::append(FileId file, std::vector<unsigned char> data) {
+    Operation operation;
+    operation.kind = Operation::Append;
+    operation.file = file;
+    operation.data = std::move(data);
+    enqueue(std::move(operation));
+}
+
+void OutputWriter::close(FileId file) {
+    Operation operation;
+    operation.kind = Operation::Close;
+    operation.file = file;
+    enqueue(std::move(operation));
+}
+
+void OutputWriter::discard(FileId file) {
+    Operation operation;
+    operation.kind = Operation::Discard;
+    operation.file = file;
+    enqueue(std::move(operation));
+}
+
+void OutputWriter::write(const std::string& path, std::vector<unsigned char> data) {
+    FileId file = open(path);
+    append(file, std::move(data));
+    close(file);
+}
+
+std::vector<std::string> OutputWriter::flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    allWritten_.wait(lock, [this] { return pendingOperations_ == 0; });
+    std::vector<std::string> failed;
+    failed.swap(failedPaths_);
+    return failed;
+}
+
+OutputWriterStats OutputWriter::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+// Порция больше предела тоже принимается, но только в пустую очередь
+void OutputWriter::enqueue(Operation operation) {
+    size_t size = operation.data.size();
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (queuedBytes_ > 0 && queuedBytes_ + size > maxQueuedBytes_) {
+            stats_.stalls++;
+            spaceAvailable_.wait(lock, [this, size] {
+                return queuedBytes_ == 0 || queuedBytes_ + size <= maxQueuedBytes_;
+            });
+        }
+        queuedBytes_ += size;
+        pendingOperations_++;
+        queue_.push_back(std::move(operation));
+    }
+    operationReady_.notify_one();
+}
+
+void OutputWriter::run() {
+    for (;;) {
+        Operation operation;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            // Пока новых операций нет, дожидаемся завершения записей в полете
+            while (queue_.empty() && ring_ && ring_->inFlight > 0) {
+                lock.unlock();
+                reapCompletions(true);
+                lock.lock();
+            }
+            operationReady_.wait(lock, [this] { return !queue_.empty() || stopping_; });
+            if (queue_.empty()) {
+                break;
+            }
+            operation = std::move(queue_.front());
+            queue_.pop_front();
+        }
+        execute(operation);
+    }
+}
+
+void OutputWriter::execute(Operation& operation) {
+    switch (operation.kind) {
+        case Operation::Open: {
+            auto file = std::make_unique<OpenFile>();
+            file->path = operation.path;
+#ifdef FBT_OUTPUT_IO_URING
+            if (ring_) {
+                file->fd = ::open(file->path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+                file->failed = file->fd < 0;
+            } else
+#endif
+            {
+                file->out.open(file->path, std::ios::binary | std::ios::trunc);
+                file->failed = !file->out;
+            }
+            files_[operation.file] = std::move(file);
+            completeOperation(0, 0);
+            break;
+        }
+        case Operation::Append: {
+            OpenFile& file = *files_.at(operation.file);
+            size_t size = operation.data.size();
+            if (file.failed || size == 0) {
+                completeOperation(size, 0);
+            } else if (ring_) {
+                submitWrite(file, operation); // Завершится в reapCompletions
+            } else {
+                file.out.write(reinterpret_cast<const char*>(operation.data.data()), static_cast<std::streamsize>(size));
+                file.failed = !file.out;
+                completeOperation(size, file.failed ? 0 : size);
+            }
+            break;
+        }
+        case Operation::Close:
+        case Operation::Discard: {
+            OpenFile& file = *files_.at(operation.file);
+            file.closing = true;
+            file.discarded = operation.kind == Operation::Discard;
+            if (file.inFlight == 0) {
+                finishFile(operation.file);
+            }
+            completeOperation(0, 0);
+            break;
+        }
+    }
+}
+
+void OutputWriter::submitWrite(OpenFile& file, Operation& operation) {
+#ifdef FBT_OUTPUT_IO_URING
+    while (ring_->freeSlots.empty()) {
+        reapCompletions(true);
+    }
+    size_t index = ring_->freeSlots.back();
+    ring_->freeSlots.pop_back();
+
+    Ring::Slot& slot = ring_->slots[index];
+    slot.file = operation.file;
+    slot.fd = file.fd;
+    slot.data = std::move(operation.data);
+    slot.written = 0;
+    slot.offset = file.offset;
+    file.offset += slot.data.size();
+    file.inFlight++;
+    ring_->inFlight++;
+
+    ring_->push(index);
+    reapCompletions(false);
+#else
+    (void)file;
+    (void)operation;
+#endif
+}
+
+// Разбор завершенных записей; недописанная часть отправляется повторно.
+// С wait сначала ждет хотя бы одного завершения
+void OutputWriter::reapCompletions(bool wait) {
+#ifdef FBT_OUTPUT_IO_URING
+    bool entered = ring_->enter(wait ? 1 : 0);
+
+    uint64_t index = 0;
+    int result = 0;
+    std::vector<size_t> done;
+    while (ring_->pop(index, result)) {
+        Ring::Slot& slot = ring_->slots[index];
+        if (result > 0) {
+            slot.written += static_cast<size_t>(result);
+            if (slot.written < slot.data.size()) {
+                ring_->push(index);
+                continue;
+            }
+        } else {
+            files_.at(slot.file)->failed = true;
+        }
+        done.push_back(index);
+    }
+
+    // Кольцо неисправно: записи в полете уже не завершатся, считаем их неудачными
+    if (!entered && done.empty()) {
+        for (size_t i = 0; i < ring_->slots.size(); i++) {
+            if (std::find(ring_->freeSlots.begin(), ring_->freeSlots.end(), i) == ring_->freeSlots.end()) {
+                files_.at(ring_->slots[i].file)->failed = true;
+                done.push_back(i);
+            }
+        }
+    }
+
+    for (size_t slotIndex : done) {
+        Ring::Slot& slot = ring_->slots[slotIndex];
+        size_t size = slot.data.size();
+        size_t written = std::min(slot.written, size);
+        std::vector<unsigned char>().swap(slot.data);
+        ring_->freeSlots.push_back(slotIndex);
+        ring_->inFlight--;
+
+        OpenFile& file = *files_.at(slot.file);
+        file.inFlight--;
+        if (file.closing && file.inFlight == 0) {
+            finishFile(slot.file);
+        }
+        completeOperation(size, written);
+    }
+#else
+    (void)wait;
+#endif
+}
+
+// Закрытие файла после его последней записи; недописанный или брошенный файл удаляется
+void OutputWriter::finishFile(FileId id) {
+    auto it = files_.find(id);
+    OpenFile& file = *it->second;
+#ifdef FBT_OUTPUT_IO_URING
+    if (file.fd >= 0 && ::close(file.fd) != 0) {
+        file.failed = true;
+    }
+#endif
+    if (file.out.is_open()) {
+        file.out.close();
+        file.failed = file.failed || file.out.fail();
+    }
+    if (file.failed || file.discarded) {
+        std::error_code ec;
+        std::filesystem::remove(file.path, ec);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.files++;
+        if (file.failed && !file.discarded) {
+            stats_.failures++;
+            failedPaths_.push_back(file.path);
+        }
+    }
+    files_.erase(it);
+}
+
+void OutputWriter::completeOperation(size_t queuedBytes, size_t writtenBytes) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queuedBytes_ -= queuedBytes;
+        stats_.bytes += writtenBytes;
+        pendingOperations_--;
+    }
+    spaceAvailable_.notify_all();
+    allWritten_.notify_all();
+}
@@ -0,0 +1,99 @@
+#ifndef OUTPUT_WRITER_H
+#define OUTPUT_WRITER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Статистика асинхронной записи
+struct OutputWriterStats {
+    size_t files = 0;    // Закрытые файлы, включая неудачные
+    size_t bytes = 0;    // Записанные байты
+    size_t stalls = 0;   // Ожидания отдающих потоков при заполненной очереди
+    size_t failures = 0; // Файлы, которые не удалось записать
+    bool ioUring = false;
+};
+
+// Запись выходных файлов отдельным потоком.
+// Рабочие потоки отдают готовые байты и сразу переходят к следующему файлу,
+// не дожидаясь диска. Объем данных в очереди ограничен: при его превышении
+// отдающий поток ждет (обратное давление), поэтому память не растет, если диск
+// медленнее кодирования. Данные одного файла пишутся в порядке подачи.
+// В Linux при сборке с FBT_RENDER_IO_URING данные пишутся через io_uring с
+// несколькими операциями в полете; если ядро его не поддерживает - обычной
+// записью в том же потоке. Ошибки записи копятся и возвращаются из flush().
+// Все методы, кроме flush и деструктора, можно вызывать из любого потока.
+class OutputWriter {
+public:
+    using FileId = size_t;
+
+    static const size_t DEFAULT_QUEUE_BYTES;
+
+    explicit OutputWriter(size_t maxQueuedBytes = DEFAULT_QUEUE_BYTES);
+    ~OutputWriter(); // Дописывает очередь и останавливает поток
+
+    OutputWriter(const OutputWriter&) = delete;
+    OutputWriter& operator=(const OutputWriter&) = delete;
+
+    // Файл по частям: open, append в нужном порядке, close
+    FileId open(const std::string& path);
+    void append(FileId file, std::vector<unsigned char> data);
+    void close(FileId file);
+    // Вместо close для брошенного файла: недописанный файл удаляется и
+    // не попадает в неудачные - об ошибке уже сообщил отдающий поток
+    void discard(FileId file);
+    // Файл целиком
+    void write(const std::string& path, std::vector<unsigned char> data);
+
+    // Ждет записи всего поставленного в очередь; возвращает пути файлов,
+    // которые не удалось записать с прошлого вызова (недописанные файлы удаляются)
+    std::vector<std::string> flush();
+
+    OutputWriterStats getStats() const;
+
+private:
+    struct Operation {
+        enum Kind { Open, Append, Close, Discard } kind = Open;
+        FileId file = 0;
+        std::string path;
+        std::vector<unsigned char> data;
+    };
+    struct OpenFile;
+    struct Ring;
+
+    size_t maxQueuedBytes_;
+    std::unique_ptr<Ring> ring_; // Пуст без io_uring
+
+    mutable std::mutex mutex_;
+    std::condition_variable operationReady_;
+    std::condition_variable spaceAvailable_;
+    std::condition_variable allWritten_;
+    std::deque<Operation> queue_;
+    size_t queuedBytes_ = 0;  // Данные в очереди и в полете
+    size_t pendingOperations_ = 0; // Операции в очереди плюс незавершенные
+    FileId nextFile_ = 0;
+    bool stopping_ = false;
+    OutputWriterStats stats_;
+    std::vector<std::string> failedPaths_;
+
+    // Состояние потока записи
+    std::map<FileId, std::unique_ptr<OpenFile>> files_;
+
+    std::thread thread_;
+
+    void enqueue(Operation operation);
+    void run();
+    void execute(Operation& operation);
+    void submitWrite(OpenFile& file, Operation& operation);
+    void reapCompletions(bool wait);
+    void finishFile(FileId id);
+    void completeOperation(size_t queuedBytes, size_t writtenBytes);
+};
+
+#endif
@@ -0,0 +1,589 @@
+#include "png_encoder.h"
+#include "output_writer.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <unordered_map>
+#include <zlib.h>
+
+namespace {
+    // Таблица CRC32 (полином 0xEDB88320), строится один раз
+    const uint32_t* crcTable() {
+        static uint32_t table[256];
+        static bool initialized = [] {
+            for (uint32_t n = 0; n < 256; n++) {
+                uint32_t c = n;
+                for (int k = 0; k < 8; k++) {
+                    c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                }
+                table[n] = c;
+            }
+            return true;
+        }();
+        (void)initialized;
+        return table;
+    }
+
+    uint32_t updateCrc(uint32_t crc, const unsigned char* data, size_t size) {
+        const uint32_t* table = crcTable();
+        for (size_t i = 0; i < size; i++) {
+            crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        }
+        return crc;
+    }
+
+    void appendU32(std::vector<unsigned char>& out, uint32_t value) {
+        out.push_back(static_cast<unsigned char>(value >> 24));
+        out.push_back(static_cast<unsigned char>(value >> 16));
+        out.push_back(static_cast<unsigned char>(value >> 8));
+        out.push_back(static_cast<unsigned char>(value));
+    }
+
+    void appendChunk(std::vector<unsigned char>& out, const char* type,
+                     const unsigned char* data, size_t size) {
+        appendU32(out, static_cast<uint32_t>(size));
+        size_t typeStart = out.size();
+        out.insert(out.end(), type, type + 4);
+        if (size > 0) {
+            out.insert(out.end(), data, data + size);
+        }
+        uint32_t crc = updateCrc(0xFFFFFFFFu, out.data() + typeStart, size + 4) ^ 0xFFFFFFFFu;
+        appendU32(out, crc);
+    }
+
+    // Тот же zlib и тот же уровень, что и в PngStreamWriter: --png-level одинаково
+    // действует на интерфейсы и на сети; уровень 0 дает несжатые блоки deflate
+    bool compressZlib(const std::vector<unsigned char>& data, int level, std::vector<unsigned char>& out) {
+        uLongf compressedSize = compressBound(static_cast<uLong>(data.size()));
+        out.resize(compressedSize);
+        int result = compress2(out.data(), &compressedSize, data.data(), static_cast<uLong>(data.size()),
+                               std::max(0, std::min(level, 9)));
+        if (result != Z_OK) {
+            return false;
+        }
+        out.resize(compressedSize);
+        return true;
+    }
+
+    inline uint32_t packColor(const unsigned char* pixel) {
+        return (static_cast<uint32_t>(pixel[0]) << 16) | (static_cast<uint32_t>(pixel[1]) << 8) | pixel[2];
+    }
+
+    // Точное построение палитры. Возвращает false, если цветов больше 256.
+    bool buildExactPalette(const unsigned char* rgb, int width, int height, int stride,
+                           std::vector<uint32_t>& palette, std::vector<unsigned char>& indices) {
+        // Открытая адресация: 1024 ячейки на максимум 256 цветов
+        const uint32_t EMPTY = 0xFFFFFFFFu;
+        uint32_t keys[1024];
+        unsigned char values[1024];
+        std::fill(keys, keys + 1024, EMPTY);
+
+        palette.clear();
+        indices.resize(static_cast<size_t>(width) * height);
+
+        uint32_t lastColor = EMPTY;
+        unsigned char lastIndex = 0;
+
+        for (int y = 0; y < height; y++) {
+            const unsigned char* row = rgb + static_cast<size_t>(y) * stride;
+            unsigned char* outRow = indices.data() + static_cast<size_t>(y) * width;
+            for (int x = 0; x < width; x++) {
+                uint32_t color = packColor(row + x * 3);
+                // Большая часть изображения - длинные серии одного цвета
+                if (color != lastColor) {
+                    uint32_t slot = (color * 2654435761u) >> 22;
+                    while (keys[slot] != EMPTY && keys[slot] != color) {
+                        slot = (slot + 1) & 1023;
+                    }
+                    if (keys[slot] == EMPTY) {
+                        if (palette.size() == 256) {
+                            return false;
+                        }
+                        keys[slot] = color;
+                        values[slot] = static_cast<unsigned char>(palette.size());
+                        palette.push_back(color);
+                    }
+                    lastColor = color;
+                    lastIndex = values[slot];
+                }
+                outRow[x] = lastIndex;
+            }
+        }
+        return true;
+    }
+
+    // Квантование по популярности: 256 самых частых цветов, остальные -
+    // к ближайшему из них. Для диаграмм с несколькими базовыми цветами и
+    // сглаживанием этого достаточно.
+    void buildQuantizedPalette(const unsigned char* rgb, int width, int height, int stride,
+                               std::vector<uint32_t>& palette, std::vector<unsigned char>& indices) {
+        std::unordered_map<uint32_t, size_t> counts;
+        for (int y = 0; y < height; y++) {
+            const unsigned char* row = rgb + static_cast<size_t>(y) * stride;
+            for (int x = 0; x < width; x++) {
+                counts[packColor(row + x * 3)]++;
+            }
+        }
+
+        std::vector<std::pair<uint32_t, size_t>> sorted(counts.begin(), counts.end());
+        std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) {
+            return a.second != b.second ? a.second > b.second : a.first < b.first;
+        });
+
+        palette.clear();
+        for (size_t i = 0; i < sorted.size() && i < 256; i++) {
+            palette.push_back(sorted[i].first);
+        }
+
+        // Индекс ближайшего цвета палитры для каждого встреченного цвета
+        std::unordered_map<uint32_t, unsigned char> mapping;
+        mapping.reserve(sorted.size());
+        for (const auto& entry : sorted) {
+            uint32_t color = entry.first;
+            int r = (color >> 16) & 0xFF, g = (color >> 8) & 0xFF, b = color & 0xFF;
+            int bestIndex = 0;
+            int bestDistance = -1;
+            for (size_t i = 0; i < palette.size(); i++) {
+                int dr = r - static_cast<int>((palette[i] >> 16) & 0xFF);
+                int dg = g - static_cast<int>((palette[i] >> 8) & 0xFF);
+                int db = b - static_cast<int>(palette[i] & 0xFF);
+                int distance = dr * dr + dg * dg + db * db;
+                if (bestDistance < 0 || distance < bestDistance) {
+                    bestDistance = distance;
+                    bestIndex = static_cast<int>(i);
+                }
+            }
+            mapping[color] = static_cast<unsigned char>(bestIndex);
+        }
+
+        indices.resize(static_cast<size_t>(width) * height);
+        for (int y = 0; y < height; y++) {
+            const unsigned char* row = rgb + static_cast<size_t>(y) * stride;
+            for (int x = 0; x < width; x++) {
+                indices[static_cast<size_t>(y) * width + x] = mapping[packColor(row + x * 3)];
+            }
+        }
+    }
+
+    inline unsigned char paethPredictor(int a, int b, int c) {
+        int p = a + b - c;
+        int pa = std::abs(p - a);
+        int pb = std::abs(p - b);
+        int pc = std::abs(p - c);
+        if (pa <= pb && pa <= pc) return static_cast<unsigned char>(a);
+        if (pb <= pc) return static_cast<unsigned char>(b);
+        return static_cast<unsigned char>(c);
+    }
+
+    // Применяет фильтр type (1-4) к строке; prev - предыдущая нефильтрованная строка
+    void filterRow(int type, const unsigned char* cur, const unsigned char* prev,
+                   size_t length, int bpp, unsigned char* out) {
+        for (size_t i = 0; i < length; i++) {
+            int left = i >= static_cast<size_t>(bpp) ? cur[i - bpp] : 0;
+            int up = prev[i];
+            int upLeft = i >= static_cast<size_t>(bpp) ? prev[i - bpp] : 0;
+            int predicted = 0;
+            switch (type) {
+                case 1: predicted = left; break;
+                case 2: predicted = up; break;
+                case 3: predicted = (left + up) / 2; break;
+                case 4: predicted = paethPredictor(left, up, upLeft); break;
+                default: break;
+            }
+            out[i] = static_cast<unsigned char>(cur[i] - predicted);
+        }
+    }
+
+    // Фильтрует одну строку в dst: байт типа фильтра и данные.
+    // scratch - временная строка длины rowLength для адаптивного выбора.
+    void filterImageRow(const unsigned char* cur, const unsigned char* prev, size_t rowLength, int bpp,
+                        PngFilter strategy, unsigned char* scratch, unsigned char* dst) {
+        int type = 0;
+        switch (strategy) {
+            case PngFilter::None: type = 0; break;
+            case PngFilter::Sub: type = 1; break;
+            case PngFilter::Up: type = 2; break;
+            case PngFilter::Average: type = 3; break;
+            case PngFilter::Paeth: type = 4; break;
+            case PngFilter::Adaptive: {
+                // Эвристика из спецификации PNG: минимальная сумма модулей байт как signed
+                uint64_t bestScore = UINT64_MAX;
+                for (int t = 0; t <= 4; t++) {
+                    const unsigned char* filtered = cur;
+                    if (t > 0) {
+                        filterRow(t, cur, prev, rowLength, bpp, scratch);
+                        filtered = scratch;
+                    }
+                    uint64_t score = 0;
+                    for (size_t i = 0; i < rowLength && score < bestScore; i++) {
+                        score += std::abs(static_cast<int>(static_cast<signed char>(filtered[i])));
+                    }
+                    if (score < bestScore) {
+                        bestScore = score;
+                        type = t;
+                    }
+                }
+                break;
+            }
+        }
+
+        dst[0] = static_cast<unsigned char>(type);
+        if (type == 0) {
+            std::memcpy(dst + 1, cur, rowLength);
+        } else {
+            filterRow(type, cur, prev, rowLength, bpp, dst + 1);
+        }
+    }
+
+    // Добавляет к строкам байт типа фильтра и применяет выбранную стратегию
+    void filterImage(const std::vector<unsigned char>& rows, size_t rowLength, int height, int bpp,
+                     PngFilter strategy, std::vector<unsigned char>& out) {
+        out.resize((rowLength + 1) * height);
+        std::vector<unsigned char> zeroRow(rowLength, 0);
+        std::vector<unsigned char> candidate(rowLength);
+
+        for (int y = 0; y < height; y++) {
+            const unsigned char* cur = rows.data() + y * rowLength;
+            const unsigned char* prev = y > 0 ? cur - rowLength : zeroRow.data();
+            filterImageRow(cur, prev, rowLength, bpp, strategy, candidate.data(),
+                           out.data() + y * (rowLength + 1));
+        }
+    }
+
+    const unsigned char PNG_SIGNATURE[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+
+    void appendHeader(std::vector<unsigned char>& out, int width, int height, int bitDepth, bool indexed) {
+        std::vector<unsigned char> header;
+        appendU32(header, static_cast<uint32_t>(width));
+        appendU32(header, static_cast<uint32_t>(height));
+        header.push_back(static_cast<unsigned char>(bitDepth));
+        header.push_back(indexed ? 3 : 2); // Тип цвета: 3 - палитра, 2 - RGB
+        header.push_back(0);               // Сжатие deflate
+        header.push_back(0);               // Стандартная фильтрация
+        header.push_back(0);               // Без чересстрочности
+        appendChunk(out, "IHDR", header.data(), header.size());
+    }
+}
+
+PngEncoder::PngEncoder(const PngOptions& options) : options_(options) {}
+
+bool PngEncoder::encode(const unsigned char* rgb, int width, int height, int stride,
+                        std::vector<unsigned char>& output) const {
+    if (width <= 0 || height <= 0) {
+        return false;
+    }
+
+    std::vector<uint32_t> palette;
+    std::vector<unsigned char> indices;
+    bool indexed = false;
+
+    if (options_.colorMode != PngColorMode::Rgb) {
+        indexed = buildExactPalette(rgb, width, height, stride, palette, indices);
+        if (!indexed && options_.colorMode == PngColorMode::Palette) {
+            buildQuantizedPalette(rgb, width, height, stride, palette, indices);
+            indexed = true;
+        }
+    }
+
+    // Строки изображения без байта фильтра
+    std::vector<unsigned char> rows;
+    size_t rowLength = 0;
+    int bitDepth = 8;
+    int bpp = 3;
+
+    if (indexed) {
+        bitDepth = palette.size() <= 2 ? 1 : palette.size() <= 4 ? 2 : palette.size() <= 16 ? 4 : 8;
+        bpp = 1;
+        int pixelsPerByte = 8 / bitDepth;
+        rowLength = (static_cast<size_t>(width) + pixelsPerByte - 1) / pixelsPerByte;
+        rows.assign(rowLength * height, 0);
+
+        // Упаковка индексов, старшие биты - левые пиксели
+        for (int y = 0; y < height; y++) {
+            const unsigned char* src = indices.data() + static_cast<size_t>(y) * width;
+            unsigned char* dst = rows.data() + y * rowLength;
+            if (bitDepth == 8) {
+                std::memcpy(dst, src, width);
+                continue;
+            }
+            for (int x = 0; x < width; x++) {
+                int shift = 8 - bitDepth * (x % pixelsPerByte + 1);
+                dst[x / pixelsPerByte] |= static_cast<unsigned char>(src[x] << shift);
+            }
+        }
+    } else {
+        rowLength = static_cast<size_t>(width) * 3;
+        rows.resize(rowLength * height);
+        for (int y = 0; y < height; y++) {
+            std::memcpy(rows.data() + y * rowLength, rgb + static_cast<size_t>(y) * stride, rowLength);
+        }
+    }
+
+    // Для палитровых изображений адаптивная фильтрация почти всегда хуже отсутствия фильтра
+    PngFilter strategy = options_.filter;
+    if (indexed && strategy == PngFilter::Adaptive) {
+        strategy = PngFilter::None;
+    }
+
+    std::vector<unsigned char> filtered;
+    filterImage(rows, rowLength, height, bpp, strategy, filtered);
+
+    std::vector<unsigned char> compressed;
+    if (!compressZlib(filtered, options_.compressionLevel, compressed)) {
+        return false;
+    }
+
+    output.assign(PNG_SIGNATURE, PNG_SIGNATURE + 8);
+    appendHeader(output, width, height, bitDepth, indexed);
+
+    if (indexed) {
+        std::vector<unsigned char> paletteData;
+        for (uint32_t color : palette) {
+            paletteData.push_back(static_cast<unsigned char>(color >> 16));
+            paletteData.push_back(static_cast<unsigned char>(color >> 8));
+            paletteData.push_back(static_cast<unsigned char>(color));
+        }
+        appendChunk(output, "PLTE", paletteData.data(), paletteData.size());
+    }
+
+    appendChunk(output, "IDAT", compressed.data(), compressed.size());
+    appendChunk(output, "IEND", nullptr, 0);
+    return true;
+}
+
+bool PngEncoder::writeFile(const std::string& path, const unsigned char* rgb, int width, int height, int stride) const {
+    std::vector<unsigned char> png;
+    if (!encode(rgb, width, height, stride, png)) {
+        return false;
+    }
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        return false;
+    }
+    out.write(reinterpret_cast<const char*>(png.data()), static_cast<std::streamsize>(png.size()));
+    return static_cast<bool>(out);
+}
+
+// Размер буфера сжатых данных и, соответственно, наибольшего блока IDAT
+static const size_t DEFLATE_BUFFER_SIZE = 64 * 1024;
+
+struct PngStreamWriter::Deflate {
+    z_stream stream{};
+    std::vector<unsigned char> buffer;
+    bool initialized = false;
+
+    ~Deflate() {
+        if (initialized) {
+            deflateEnd(&stream);
+        }
+    }
+};
+
+PngStreamWriter::PngStreamWriter(const PngOptions& options) : options_(options) {}
+
+PngStreamWriter::~PngStreamWriter() {
+    abort();
+}
+
+bool PngStreamWriter::open(const std::string& path, int width, int height, OutputWriter* writer) {
+    abort();
+    if (width <= 0 || height <= 0) {
+        return false;
+    }
+
+    deflate_ = std::make_unique<Deflate>();
+    int level = std::max(0, std::min(options_.compressionLevel, 9));
+    if (deflateInit(&deflate_->stream, level) != Z_OK) {
+        deflate_.reset();
+        return false;
+    }
+    deflate_->initialized = true;
+    deflate_->buffer.resize(DEFLATE_BUFFER_SIZE);
+    deflate_->stream.next_out = deflate_->buffer.data();
+    deflate_->stream.avail_out = static_cast<uInt>(deflate_->buffer.size());
+
+    if (writer) {
+        writer_ = writer;
+        writerFile_ = writer->open(path);
+    } else {
+        out_.open(path, std::ios::binary | std::ios::trunc);
+        if (!out_) {
+            abort();
+            return false;
+        }
+        path_ = path;
+    }
+
+    width_ = width;
+    height_ = height;
+    rowsWritten_ = 0;
+    size_t rowLength = static_cast<size_t>(width) * 3;
+    previousRow_.assign(rowLength, 0);
+    filteredRow_.resize(rowLength + 1);
+    scratchRow_.resize(rowLength);
+
+    std::vector<unsigned char> header(PNG_SIGNATURE, PNG_SIGNATURE + 8);
+    appendHeader(header, width, height, 8, false);
+    if (writer_) {
+        writer_->append(writerFile_, std::move(header));
+        return true;
+    }
+    out_.write(reinterpret_cast<const char*>(header.data()), static_cast<std::streamsize>(header.size()));
+    if (!out_) {
+        abort();
+        return false;
+    }
+    return true;
+}
+
+bool PngStreamWriter::writeRows(const unsigned char* rgb, int rows, int stride) {
+    if (!deflate_ || rows < 0 || rowsWritten_ + rows > height_) {
+        return false;
+    }
+
+    size_t rowLength = static_cast<size_t>(width_) * 3;
+    for (int y = 0; y < rows; y++) {
+        const unsigned char* cur = rgb + static_cast<size_t>(y) * stride;
+        filterImageRow(cur, previousRow_.data(), rowLength, 3, options_.filter,
+                       scratchRow_.data(), filteredRow_.data());
+        std::memcpy(previousRow_.data(), cur, rowLength);
+
+        deflate_->stream.next_in = filteredRow_.data();
+        deflate_->stream.avail_in = static_cast<uInt>(filteredRow_.size());
+        if (!deflateAvailable(Z_NO_FLUSH)) {
+            abort();
+            return false;
+        }
+        rowsWritten_++;
+    }
+    return true;
+}
+
+bool PngStreamWriter::finish() {
+    if (!deflate_ || rowsWritten_ != height_) {
+        abort();
+        return false;
+    }
+
+    deflate_->stream.next_in = nullptr;
+    deflate_->stream.avail_in = 0;
+    if (!deflateAvailable(Z_FINISH) || !writeChunk("IEND", nullptr, 0)) {
+        abort();
+        return false;
+    }
+    deflate_.reset();
+    if (writer_) {
+        // Ошибка записи станет известна только из OutputWriter::flush()
+        writer_->close(writerFile_);
+        writer_ = nullptr;
+        return true;
+    }
+    out_.close();
+    if (out_.fail()) {
+        abort();
+        return false;
+    }
+    path_.clear();
+    return true;
+}
+
+// Прогоняет входные данные через deflate; каждый заполненный буфер уходит в файл блоком IDAT
+bool PngStreamWriter::deflateAvailable(int flush) {
+    z_stream& stream = deflate_->stream;
+    for (;;) {
+        int result = ::deflate(&stream, flush);
+        if (result == Z_STREAM_ERROR) {
+            return false;
+        }
+
+        size_t pending = deflate_->buffer.size() - stream.avail_out;
+        bool bufferFull = stream.avail_out == 0;
+        bool done = flush == Z_FINISH ? result == Z_STREAM_END : stream.avail_in == 0 && !bufferFull;
+        if ((bufferFull || (done && flush == Z_FINISH)) && pending > 0) {
+            if (!writeChunk("IDAT", deflate_->buffer.data(), pending)) {
+                return false;
+            }
+            stream.next_out = deflate_->buffer.data();
+            stream.avail_out = static_cast<uInt>(deflate_->buffer.size());
+        }
+        if (done) {
+            return true;
+        }
+    }
+}
+
+bool PngStreamWriter::writeChunk(const char* type, const unsigned char* data, size_t size) {
+    std::vector<unsigned char> chunk;
+    chunk.reserve(size + 12);
+    appendChunk(chunk, type, data, size);
+    if (writer_) {
+        writer_->append(writerFile_, std::move(chunk));
+        return true;
+    }
+    out_.write(reinterpret_cast<const char*>(chunk.data()), static_cast<std::streamsize>(chunk.size()));
+    return static_cast<bool>(out_);
+}
+
+// Бросает незавершенный файл: усеченный PNG не должен остаться на диске
+void PngStreamWriter::abort() {
+    deflate_.reset();
+    if (writer_) {
+        writer_->discard(writerFile_);
+        writer_ = nullptr;
+    }
+    if (out_.is_open()) {
+        out_.close();
+    }
+    out_.clear();
+    if (!path_.empty()) {
+        std::error_code ec;
+        std::filesystem::remove(path_, ec);
+        path_.clear();
+    }
+}
+
+bool PngEncoder::parseCompressionLevel(const std::string& text, int& level) {
+    if (text == "fast") {
+        level = 1;
+    } else if (text == "default") {
+        level = 6;
+    } else if (text == "max") {
+        level = 9;
+    } else if (text.size() == 1 && text[0] >= '0' && text[0] <= '9') {
+        level = text[0] - '0';
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool PngEncoder::parseFilter(const std::string& text, PngFilter& filter) {
+    if (text == "none") filter = PngFilter::None;
+    else if (text == "sub") filter = PngFilter::Sub;
+    else if (text == "up") filter = PngFilter::Up;
+    else if (text == "average") filter = PngFilter::Average;
+    else if (text == "paeth") filter = PngFilter::Paeth;
+    else if (text == "adaptive") filter = PngFilter::Adaptive;
+    else return false;
+    return true;
+}
+
+bool PngEncoder::parseColorMode(const std::string& text, PngColorMode& mode) {
+    if (text == "auto") mode = PngColorMode::Auto;
+    else if (text == "palette") mode = PngColorMode::Palette;
+    else if (text == "rgb") mode = PngColorMode::Rgb;
+    else return false;
+    return true;
+}
+
+std::string PngEncoder::describe(const PngOptions& options) {
+    static const char* filterNames[] = {"none", "sub", "up", "average", "paeth", "adaptive"};
+    static const char* colorNames[] = {"auto", "palette", "rgb"};
+    return "level=" + std::to_string(options.compressionLevel) +
+           ",filter=" + filterNames[static_cast<int>(options.filter)] +
+           ",color=" + colorNames[static_cast<int>(options.colorMode)];
+}
@@ -0,0 +1,108 @@
+#ifndef PNG_ENCODER_H
+#define PNG_ENCODER_H
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+class OutputWriter;
+
+// Стратегия фильтрации строк PNG
+enum class PngFilter {
+    None,
+    Sub,
+    Up,
+    Average,
+    Paeth,
+    Adaptive // Для каждой строки выбирается фильтр с минимальной суммой модулей
+};
+
+// Цветовой режим выходного файла
+enum class PngColorMode {
+    Auto,    // Палитра, если в изображении не больше 256 цветов, иначе RGB
+    Palette, // Всегда палитра; при большем числе цветов - квантование
+    Rgb      // Всегда 24-битный RGB
+};
+
+// Настройки кодирования PNG
+struct PngOptions {
+    int compressionLevel = 6; // 0 - без сжатия, 1 - быстро, 9 - максимально
+    PngFilter filter = PngFilter::Adaptive;
+    PngColorMode colorMode = PngColorMode::Auto;
+};
+
+// Кодировщик PNG для RGB изображений в памяти.
+// Диаграммы FB содержат лишь несколько базовых цветов и оттенки сглаживания текста,
+// поэтому в большинстве случаев изображение без потерь записывается как палитровое
+// (1-8 бит на пиксель), что заметно уменьшает размер и время сжатия.
+class PngEncoder {
+public:
+    explicit PngEncoder(const PngOptions& options = PngOptions());
+
+    // Кодирует RGB изображение (3 байта на пиксель) в PNG в памяти
+    bool encode(const unsigned char* rgb, int width, int height, int stride,
+                std::vector<unsigned char>& output) const;
+
+    // Кодирует и записывает PNG в файл
+    bool writeFile(const std::string& path, const unsigned char* rgb, int width, int height, int stride) const;
+
+    const PngOptions& getOptions() const { return options_; }
+
+    // Разбор значений параметров командной строки
+    static bool parseCompressionLevel(const std::string& text, int& level);
+    static bool parseFilter(const std::string& text, PngFilter& filter);
+    static bool parseColorMode(const std::string& text, PngColorMode& mode);
+    // Краткое описание настроек (для отпечатка генератора)
+    static std::string describe(const PngOptions& options);
+
+private:
+    PngOptions options_;
+};
+
+// Потоковая запись RGB PNG для изображений, которые не помещаются в память целиком
+// (сети составных FB). Строки подаются полосами сверху вниз и сразу фильтруются и
+// сжимаются zlib; в памяти держатся только предыдущая строка и буфер deflate,
+// а данные уходят в файл отдельными блоками IDAT.
+// Палитра не используется: для ее построения нужно видеть все изображение.
+// С OutputWriter блоки уходят в его очередь, и кодирование не ждет диска.
+class PngStreamWriter {
+public:
+    explicit PngStreamWriter(const PngOptions& options = PngOptions());
+    ~PngStreamWriter();
+
+    PngStreamWriter(const PngStreamWriter&) = delete;
+    PngStreamWriter& operator=(const PngStreamWriter&) = delete;
+
+    // Создает файл и записывает заголовок; при writer - через его очередь
+    bool open(const std::string& path, int width, int height, OutputWriter* writer = nullptr);
+    // Добавляет очередные rows строк (3 байта на пиксель)
+    bool writeRows(const unsigned char* rgb, int rows, int stride);
+    // Завершает поток сжатия и закрывает файл; все строки должны быть переданы.
+    // Незавершенный файл (ошибка или уничтожение до finish) удаляется
+    bool finish();
+
+    int getRowsWritten() const { return rowsWritten_; }
+
+private:
+    struct Deflate;
+
+    bool deflateAvailable(int flush);
+    bool writeChunk(const char* type, const unsigned char* data, size_t size);
+    void abort();
+
+    PngOptions options_;
+    std::ofstream out_;
+    std::string path_; // Файл прямой записи, удаляемый при прерывании
+    OutputWriter* writer_ = nullptr;
+    size_t writerFile_ = 0; // OutputWriter::FileId
+    std::unique_ptr<Deflate> deflate_;
+    int width_ = 0;
+    int height_ = 0;
+    int rowsWritten_ = 0;
+    std::vector<unsigned char> previousRow_;
+    std::vector<unsigned char> filteredRow_;
+    std::vector<unsigned char> scratchRow_;
+};
+
+#endif
@@ -0,0 +1,92 @@
+#include "rect_packer.h"
+#include <algorithm>
+
+SkylinePacker::SkylinePacker(int width, int height)
+    : width_(width), height_(height), usedWidth_(0), usedHeight_(0) {
+    skyline_.push_back({0, 0, width});
+}
+
+// Может ли прямоугольник лечь левым краем на начало отрезка index;
+// y - высота, на которой он окажется (максимум по накрытым отрезкам)
+bool SkylinePacker::fits(size_t index, int width, int height, int& y) const {
+    int x = skyline_[index].x;
+    if (x + width > width_) {
+        return false;
+    }
+
+    y = 0;
+    int remaining = width;
+    for (size_t i = index; remaining > 0; i++) {
+        if (i >= skyline_.size()) {
+            return false;
+        }
+        y = std::max(y, skyline_[i].y);
+        if (y + height > height_) {
+            return false;
+        }
+        remaining -= skyline_[i].width;
+    }
+    return true;
+}
+
+bool SkylinePacker::insert(int width, int height, int& x, int& y) {
+    if (width <= 0 || height <= 0) {
+        return false;
+    }
+
+    size_t bestIndex = skyline_.size();
+    int bestY = 0;
+    int bestX = 0;
+    for (size_t i = 0; i < skyline_.size(); i++) {
+        int candidateY = 0;
+        if (fits(i, width, height, candidateY) &&
+            (bestIndex == skyline_.size() || candidateY < bestY ||
+             (candidateY == bestY && skyline_[i].x < bestX))) {
+            bestIndex = i;
+            bestY = candidateY;
+            bestX = skyline_[i].x;
+        }
+    }
+
+    if (bestIndex == skyline_.size()) {
+        return false;
+    }
+
+    x = bestX;
+    y = bestY;
+    place(bestIndex, x, y, width, height);
+    usedWidth_ = std::max(usedWidth_, x + width);
+    usedHeight_ = std::max(usedHeight_, y + height);
+    return true;
+}
+
+// Новый отрезок над прямоугольником; накрытые им отрезки укорачиваются или удаляются
+void SkylinePacker::place(size_t index, int x, int y, int width, int height) {
+    skyline_.insert(skyline_.begin() + index, {x, y + height, width});
+
+    int right = x + width;
+    for (size_t i = index + 1; i < skyline_.size();) {
+        Segment& segment = skyline_[i];
+        if (segment.x >= right) {
+            break;
+        }
+        int shrink = right - segment.x;
+        if (segment.width <= shrink) {
+            skyline_.erase(skyline_.begin() + i);
+            continue;
+        }
+        segment.x += shrink;
+        segment.width -= shrink;
+        break;
+    }
+
+    // Соседние отрезки одной высоты объединяются
+    for (size_t i = 0; i + 1 < skyline_.size();) {
+        if (skyline_[i].y == skyline_[i + 1].y) {
+            skyline_[i].width += skyline_[i + 1].width;
+            skyline_.erase(skyline_.begin() + i + 1);
+        } else {
+            i++;
+        }
+    }
+}
@@ -0,0 +1,39 @@
+#ifndef RECT_PACKER_H
+#define RECT_PACKER_H
+
+#include <cstddef>
+#include <vector>
+
+// Упаковка прямоугольников в страницу фиксированного размера по "линии горизонта"
+// (skyline, эвристика bottom-left): для каждого прямоугольника выбирается
+// позиция с наименьшей верхней границей, при равенстве - самая левая.
+// Лучшие результаты - при подаче прямоугольников по убыванию высоты.
+class SkylinePacker {
+public:
+    SkylinePacker(int width, int height);
+
+    // false - прямоугольник не помещается на странице
+    bool insert(int width, int height, int& x, int& y);
+
+    int getUsedWidth() const { return usedWidth_; }
+    int getUsedHeight() const { return usedHeight_; }
+
+private:
+    // Горизонтальный отрезок линии горизонта
+    struct Segment {
+        int x;
+        int y;
+        int width;
+    };
+
+    int width_;
+    int height_;
+    int usedWidth_;
+    int usedHeight_;
+    std::vector<Segment> skyline_;
+
+    bool fits(size_t index, int width, int height, int& y) const;
+    void place(size_t index, int x, int y, int width, int height);
+};
+
+#endif
@@ -0,0 +1,349 @@
+#include "render_server.h"
+#include "utils.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    // Ограничение на размер присланного XML - защита от некорректного заголовка
+    const size_t MAX_REQUEST_BYTES = 64 * 1024 * 1024;
+
+    std::vector<std::string> splitArgs(const std::string& line) {
+        std::vector<std::string> args;
+        size_t start = 0;
+        while (start <= line.size()) {
+            size_t end = line.find('\t', start);
+            if (end == std::string::npos) {
+                end = line.size();
+            }
+            args.push_back(line.substr(start, end - start));
+            start = end + 1;
+        }
+        return args;
+    }
+}
+
+// Двунаправленный канал запросов: stdin/stdout или сокет
+class ServerChannel {
+public:
+    virtual ~ServerChannel() = default;
+    virtual bool readLine(std::string& line) = 0;
+    virtual bool readBytes(size_t size, std::string& data) = 0;
+    virtual bool write(const char* data, size_t size) = 0;
+
+    bool writeLine(const std::string& line) {
+        std::string text = line + "\n";
+        return write(text.data(), text.size());
+    }
+};
+
+namespace {
+    class StreamChannel : public ServerChannel {
+    public:
+        StreamChannel(std::istream& in, std::ostream& out) : in_(in), out_(out) {}
+
+        bool readLine(std::string& line) override {
+            if (!std::getline(in_, line)) {
+                return false;
+            }
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+            return true;
+        }
+
+        bool readBytes(size_t size, std::string& data) override {
+            data.resize(size);
+            in_.read(&data[0], static_cast<std::streamsize>(size));
+            return static_cast<size_t>(in_.gcount()) == size;
+        }
+
+        bool write(const char* data, size_t size) override {
+            out_.write(data, static_cast<std::streamsize>(size));
+            out_.flush();
+            return static_cast<bool>(out_);
+        }
+
+    private:
+        std::istream& in_;
+        std::ostream& out_;
+    };
+
+#ifndef _WIN32
+    class SocketChannel : public ServerChannel {
+    public:
+        explicit SocketChannel(int fd) : fd_(fd), begin_(0) {}
+
+        bool readLine(std::string& line) override {
+            line.clear();
+            while (true) {
+                size_t pos = buffer_.find('\n', begin_);
+                if (pos != std::string::npos) {
+                    line.assign(buffer_, begin_, pos - begin_);
+                    begin_ = pos + 1;
+                    if (!line.empty() && line.back() == '\r') {
+                        line.pop_back();
+                    }
+                    return true;
+                }
+                if (!fill()) {
+                    return false;
+                }
+            }
+        }
+
+        bool readBytes(size_t size, std::string& data) override {
+            while (buffer_.size() - begin_ < size) {
+                if (!fill()) {
+                    return false;
+                }
+            }
+            data.assign(buffer_, begin_, size);
+            begin_ += size;
+            return true;
+        }
+
+        bool write(const char* data, size_t size) override {
+            while (size > 0) {
+                ssize_t sent = ::send(fd_, data, size, MSG_NOSIGNAL);
+                if (sent <= 0) {
+                    return false;
+                }
+                data += sent;
+                size -= static_cast<size_t>(sent);
+            }
+            return true;
+        }
+
+    private:
+        int fd_;
+        std::string buffer_;
+        size_t begin_; // Начало непрочитанных данных в buffer_
+
+        bool fill() {
+            if (begin_ > 0) {
+                buffer_.erase(0, begin_);
+                begin_ = 0;
+            }
+            char chunk[65536];
+            ssize_t received = ::recv(fd_, chunk, sizeof(chunk), 0);
+            if (received <= 0) {
+                return false;
+            }
+            buffer_.append(chunk, static_cast<size_t>(received));
+            return true;
+        }
+    };
+#endif
+}
+
+RenderServer::RenderServer(const ConverterOptions& options)
+    : options_(options), requestCount_(0), shutdown_(false) {
+    // Шрифт загружается один раз; сообщения генератора не должны попасть в поток ответов
+    utils::ScopedLogCapture capture;
+    utils::createDirectoryIfNotExists(options_.outputDir);
+    generator_ = std::make_unique<ImageGenerator>();
+    generator_->setPngOptions(options_.png);
+    generator_->setMargin(options_.margin);
+    generator_->setOutputFormat(options_.format);
+    std::cerr << capture.str();
+}
+
+RenderServer::~RenderServer() = default;
+
+int RenderServer::serveStdio() {
+#ifdef _WIN32
+    _setmode(_fileno(stdin), _O_BINARY);
+    _setmode(_fileno(stdout), _O_BINARY);
+#endif
+    StreamChannel channel(std::cin, std::cout);
+    channel.writeLine("READY " + std::to_string(ImageGenerator::RENDERER_VERSION));
+    serveChannel(channel);
+    return 0;
+}
+
+int RenderServer::serveSocket(const std::string& socketPath) {
+#ifdef _WIN32
+    std::cerr << "ERROR: Unix domain sockets are not supported on this platform" << std::endl;
+    return 1;
+#else
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        std::cerr << "ERROR: Socket path is too long: " << socketPath << std::endl;
+        return 1;
+    }
+    std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+
+    int listenFd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0) {
+        std::cerr << "ERROR: Could not create socket: " << std::strerror(errno) << std::endl;
+        return 1;
+    }
+
+    // Сокет, оставшийся от предыдущего запуска, мешает bind
+    ::unlink(socketPath.c_str());
+    if (::bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        ::listen(listenFd, 16) != 0) {
+        std::cerr << "ERROR: Could not listen on " << socketPath << ": " << std::strerror(errno) << std::endl;
+        ::close(listenFd);
+        return 1;
+    }
+
+    std::cerr << "Listening on " << socketPath << std::endl;
+
+    // Соединения обслуживаются по очереди одним прогретым генератором
+    while (!shutdown_) {
+        int clientFd = ::accept(listenFd, nullptr, nullptr);
+        if (clientFd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "ERROR: accept failed: " << std::strerror(errno) << std::endl;
+            break;
+        }
+        SocketChannel channel(clientFd);
+        serveChannel(channel);
+        ::close(clientFd);
+    }
+
+    ::close(listenFd);
+    ::unlink(socketPath.c_str());
+    return 0;
+#endif
+}
+
+bool RenderServer::serveChannel(ServerChannel& channel) {
+    std::string line;
+    while (!shutdown_ && channel.readLine(line)) {
+        if (line.empty()) {
+            continue;
+        }
+
+        std::vector<std::string> args = splitArgs(line);
+        const std::string& command = args[0];
+        bool keepOpen = true;
+
+        if (command == "RENDER") {
+            keepOpen = handleRender(channel, args);
+        } else if (command == "RENDER_XML") {
+            keepOpen = handleRenderXml(channel, args);
+        } else if (command == "STATS") {
+            keepOpen = handleStats(channel);
+        } else if (command == "QUIT") {
+            return false;
+        } else if (command == "SHUTDOWN") {
+            shutdown_ = true;
+            channel.writeLine("OK");
+            return false;
+        } else {
+            keepOpen = channel.writeLine("ERROR unknown command: " + command);
+        }
+
+        if (!keepOpen) {
+            return false;
+        }
+    }
+    return false;
+}
+
+std::string RenderServer::getDefaultOutputPath(const std::string& inputPath) const {
+    return options_.outputDir + "/" + utils::getFileNameWithoutExtension(inputPath) +
+           (options_.format == OutputFormat::Svg ? ".svg" : ".png");
+}
+
+bool RenderServer::handleRender(ServerChannel& channel, const std::vector<std::string>& args) {
+    if (args.size() < 2 || args[1].empty()) {
+        return channel.writeLine("ERROR usage: RENDER <input> [<output>]");
+    }
+    requestCount_++;
+
+    const std::string& inputPath = args[1];
+    std::string outputPath = args.size() > 2 && !args[2].empty() ? args[2] : getDefaultOutputPath(inputPath);
+
+    bool parsed;
+    {
+        utils::ScopedLogCapture capture;
+        parsed = utils::fileExists(inputPath) && parser_.parseFile(inputPath);
+        std::cerr << capture.str();
+    }
+    if (!parsed) {
+        return channel.writeLine("ERROR failed to parse: " + inputPath);
+    }
+    return renderParsed(channel, outputPath);
+}
+
+bool RenderServer::handleRenderXml(ServerChannel& channel, const std::vector<std::string>& args) {
+    size_t size = 0;
+    std::istringstream sizeStream(args.size() > 1 ? args[1] : std::string());
+    if (!(sizeStream >> size) || size > MAX_REQUEST_BYTES) {
+        // Длина неизвестна - продолжить чтение протокола невозможно
+        channel.writeLine("ERROR usage: RENDER_XML <size> [<output>]");
+        return false;
+    }
+    requestCount_++;
+
+    std::string xml;
+    if (!channel.readBytes(size, xml)) {
+        return false;
+    }
+
+    bool parsed;
+    {
+        utils::ScopedLogCapture capture;
+        parsed = parser_.parseBuffer(xml.data(), xml.size());
+        std::cerr << capture.str();
+    }
+    if (!parsed) {
+        return channel.writeLine("ERROR failed to parse inline XML");
+    }
+
+    std::string outputPath = args.size() > 2 ? args[2] : std::string();
+    return renderParsed(channel, outputPath);
+}
+
+// Отрисовка последнего разобранного интерфейса: в файл или обратно клиенту
+bool RenderServer::renderParsed(ServerChannel& channel, const std::string& outputPath) {
+    const FbInterface& fb = parser_.getInterface();
+    bool success;
+    std::vector<unsigned char> data;
+    {
+        utils::ScopedLogCapture capture;
+        success = outputPath.empty() ? generator_->generateImageData(fb, data)
+                                     : generator_->generateImage(fb, outputPath);
+        std::cerr << capture.str();
+    }
+
+    if (!success) {
+        return channel.writeLine("ERROR failed to render: " + fb.name);
+    }
+    if (!outputPath.empty()) {
+        return channel.writeLine("OK " + outputPath);
+    }
+    return channel.writeLine("DATA " + std::to_string(data.size())) &&
+           channel.write(reinterpret_cast<const char*>(data.data()), data.size());
+}
+
+bool RenderServer::handleStats(ServerChannel& channel) {
+    GlyphCacheStats glyphStats = generator_->getGlyphCacheStats();
+    RenderTimings timings = generator_->getTimings();
+    std::ostringstream out;
+    out << "OK " << requestCount_ << " " << glyphStats.hits << " " << glyphStats.misses
+        << std::fixed << std::setprecision(1)
+        << " " << timings.layoutMs << " " << timings.rasterMs << " " << timings.encodeMs;
+    return channel.writeLine(out.str());
+}
@@ -0,0 +1,48 @@
+#ifndef RENDER_SERVER_H
+#define RENDER_SERVER_H
+
+#include "batch_converter.h"
+#include "xml_parser.h"
+#include "image_generator.h"
+#include <memory>
+#include <string>
+
+class ServerChannel;
+
+// Долгоживущий режим: один XmlParser и один ImageGenerator (шрифт и кэш глифов
+// загружены один раз) обслуживают запросы из stdin или через Unix-сокет.
+//
+// Протокол строковый, аргументы команды разделяются символом табуляции:
+//   RENDER <input.fbt> [<output>]  -> OK <output> | ERROR <текст>
+//   RENDER_XML <size> [<output>]   за строкой следуют size байт XML;
+//                                  -> OK <output>, если output задан,
+//                                  -> DATA <n> и n байт PNG/SVG иначе
+//   STATS                          -> OK <запросов> <попаданий> <промахов> <layout> <raster> <encode>
+//   QUIT                           завершает соединение (в stdin-режиме - сервер)
+//   SHUTDOWN                       останавливает сервер
+// Без output файл пишется в outputDir под именем входного файла.
+// Журнал генератора выводится в stderr, stdout занят ответами.
+class RenderServer {
+public:
+    explicit RenderServer(const ConverterOptions& options);
+    ~RenderServer();
+
+    int serveStdio();
+    int serveSocket(const std::string& socketPath);
+
+private:
+    ConverterOptions options_;
+    XmlParser parser_;
+    std::unique_ptr<ImageGenerator> generator_;
+    size_t requestCount_;
+    bool shutdown_;
+
+    bool serveChannel(ServerChannel& channel); // false - соединение закрыто или сервер остановлен
+    bool handleRender(ServerChannel& channel, const std::vector<std::string>& args);
+    bool handleRenderXml(ServerChannel& channel, const std::vector<std::string>& args);
+    bool handleStats(ServerChannel& channel);
+    bool renderParsed(ServerChannel& channel, const std::string& outputPath);
+    std::string getDefaultOutputPath(const std::string& inputPath) const;
+};
+
+#endif
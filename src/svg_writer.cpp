@@ -0,0 +1,112 @@
+#include "svg_writer.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+namespace {
+    std::string formatColor(const Color& color) {
+        char text[8];
+        std::snprintf(text, sizeof(text), "#%02x%02x%02x", color.r, color.g, color.b);
+        return text;
+    }
+
+    // Экранирование спецсимволов XML в тексте и значениях атрибутов
+    std::string escapeXml(const std::string& text) {
+        std::string result;
+        result.reserve(text.size());
+        for (char c : text) {
+            switch (c) {
+                case '&': result += "&amp;"; break;
+                case '<': result += "&lt;"; break;
+                case '>': result += "&gt;"; break;
+                case '"': result += "&quot;"; break;
+                default: result += c; break;
+            }
+        }
+        return result;
+    }
+}
+
+SvgWriter::SvgWriter(const std::string& fontFamily) : fontFamily_(fontFamily) {}
+
+std::string SvgWriter::render(const DisplayList& list, int margin) const {
+    int width = std::max(list.bounds.getWidth(), 1) + 2 * margin;
+    int height = std::max(list.bounds.getHeight(), 1) + 2 * margin;
+    int offsetX = list.bounds.isEmpty() ? margin : margin - list.bounds.minX;
+    int offsetY = list.bounds.isEmpty() ? margin : margin - list.bounds.minY;
+
+    std::ostringstream out;
+    out << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+    out << "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"" << width << "\" height=\"" << height
+        << "\" viewBox=\"0 0 " << width << " " << height << "\">\n";
+    out << "<rect width=\"100%\" height=\"100%\" fill=\"#ffffff\"/>\n";
+    // Линии и контуры рисуются по центрам пикселей (+0.5), как в растровом выводе
+    out << "<g shape-rendering=\"crispEdges\" font-family=\"" << escapeXml(fontFamily_) << "\">\n";
+
+    for (const DisplayItem& item : list.items) {
+        int x = item.x + offsetX;
+        int y = item.y + offsetY;
+        std::string color = formatColor(item.color);
+
+        switch (item.type) {
+            case DisplayItemType::Rectangle:
+            case DisplayItemType::Square: {
+                int rx = x, ry = y, rw = item.width, rh = item.height;
+                if (item.type == DisplayItemType::Square) {
+                    rx = x - item.size / 2;
+                    ry = y - item.size / 2;
+                    rw = rh = item.size;
+                }
+                if (rw <= 0 || rh <= 0) {
+                    break;
+                }
+                if (item.fill) {
+                    out << "<rect x=\"" << rx << "\" y=\"" << ry << "\" width=\"" << rw << "\" height=\"" << rh
+                        << "\" fill=\"" << color << "\"/>\n";
+                } else {
+                    out << "<rect x=\"" << rx + 0.5 << "\" y=\"" << ry + 0.5 << "\" width=\"" << rw - 1
+                        << "\" height=\"" << rh - 1 << "\" fill=\"none\" stroke=\"" << color << "\"/>\n";
+                }
+                break;
+            }
+            case DisplayItemType::Line:
+                out << "<line x1=\"" << x + 0.5 << "\" y1=\"" << y + 0.5
+                    << "\" x2=\"" << item.x2 + offsetX + 0.5 << "\" y2=\"" << item.y2 + offsetY + 0.5
+                    << "\" stroke=\"" << color << "\" stroke-width=\"" << item.thickness
+                    << "\" stroke-linecap=\"square\"/>\n";
+                break;
+            case DisplayItemType::Triangle: {
+                int half = item.size / 2;
+                out << "<polygon points=\"" << x << "," << y - half << " "
+                    << x + half + 1 << "," << y + 0.5 << " "
+                    << x << "," << y + half + 1 << "\" fill=\"" << color << "\"/>\n";
+                break;
+            }
+            case DisplayItemType::Text:
+                // Базовая линия смещена на fontSize/2, как в ImageGenerator::drawText
+                out << "<text x=\"" << x << "\" y=\"" << y + item.fontSize / 2
+                    << "\" font-size=\"" << item.fontSize << "\"";
+                if (item.italic) {
+                    out << " font-style=\"italic\"";
+                }
+                if (item.bold) {
+                    out << " font-weight=\"bold\"";
+                }
+                out << " fill=\"" << color << "\">" << escapeXml(item.text) << "</text>\n";
+                break;
+        }
+    }
+
+    out << "</g>\n</svg>\n";
+    return out.str();
+}
+
+bool SvgWriter::writeFile(const DisplayList& list, int margin, const std::string& path) const {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        return false;
+    }
+    out << render(list, margin);
+    return static_cast<bool>(out);
+}
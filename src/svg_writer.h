@@ -0,0 +1,22 @@
+#ifndef SVG_WRITER_H
+#define SVG_WRITER_H
+
+#include "fb_layout.h"
+#include <string>
+
+// Вывод списка отображения в SVG.
+// Координаты и размеры совпадают с PNG: элементы сдвигаются так, чтобы
+// границы разметки оказались внутри полей шириной margin.
+// Текст выводится элементами <text>, растеризацию выполняет браузер.
+class SvgWriter {
+public:
+    explicit SvgWriter(const std::string& fontFamily = "sans-serif");
+
+    std::string render(const DisplayList& list, int margin) const;
+    bool writeFile(const DisplayList& list, int margin, const std::string& path) const;
+
+private:
+    std::string fontFamily_;
+};
+
+#endif
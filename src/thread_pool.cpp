@@ -0,0 +1,111 @@
+#include "thread_pool.h"
+#include <exception>
+#include <iostream>
+
+namespace {
+    // Пул и номер рабочего потока, в котором выполняется текущий код
+    thread_local const ThreadPool* currentPool = nullptr;
+    thread_local size_t currentWorker = 0;
+}
+
+ThreadPool::ThreadPool(size_t threadCount)
+    : queued_(0), pending_(0), nextQueue_(0), stopping_(false) {
+    if (threadCount == 0) {
+        threadCount = 1;
+    }
+
+    for (size_t i = 0; i < threadCount; i++) {
+        queues_.push_back(std::make_unique<WorkerQueue>());
+    }
+    for (size_t i = 0; i < threadCount; i++) {
+        threads_.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(stateMutex_);
+        stopping_ = true;
+    }
+    workAvailable_.notify_all();
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+void ThreadPool::submit(Task task) {
+    size_t index = (currentPool == this)
+        ? currentWorker
+        : nextQueue_.fetch_add(1) % queues_.size();
+
+    pending_++;
+    {
+        // Задача кладется под мьютексом состояния, чтобы спящий поток
+        // не пропустил уведомление между проверкой условия и ожиданием
+        std::lock_guard<std::mutex> stateLock(stateMutex_);
+        std::lock_guard<std::mutex> queueLock(queues_[index]->mutex);
+        queues_[index]->tasks.push_back(std::move(task));
+        queued_++;
+    }
+    workAvailable_.notify_one();
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lock(stateMutex_);
+    allDone_.wait(lock, [this] { return pending_ == 0; });
+}
+
+bool ThreadPool::popLocal(size_t index, Task& task) {
+    WorkerQueue& queue = *queues_[index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) {
+        return false;
+    }
+    task = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    return true;
+}
+
+bool ThreadPool::steal(size_t index, Task& task) {
+    // Обходим остальные очереди, начиная с соседней
+    for (size_t offset = 1; offset < queues_.size(); offset++) {
+        WorkerQueue& victim = *queues_[(index + offset) % queues_.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::workerLoop(size_t index) {
+    currentPool = this;
+    currentWorker = index;
+
+    while (true) {
+        Task task;
+        if (popLocal(index, task) || steal(index, task)) {
+            queued_--;
+            try {
+                task(index);
+            } catch (const std::exception& e) {
+                std::cerr << "ERROR: Unhandled exception in worker " << index << ": " << e.what() << std::endl;
+            }
+
+            if (--pending_ == 0) {
+                std::lock_guard<std::mutex> lock(stateMutex_);
+                allDone_.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(stateMutex_);
+        workAvailable_.wait(lock, [this] { return stopping_ || queued_ > 0; });
+        if (stopping_ && queued_ == 0) {
+            return;
+        }
+    }
+}
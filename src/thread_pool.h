@@ -0,0 +1,59 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Пул потоков с перехватом задач (work stealing).
+// У каждого рабочего потока своя очередь: свои задачи он берет с конца (LIFO),
+// а простаивая, забирает самые старые задачи из начала чужих очередей.
+class ThreadPool {
+public:
+    // Задача получает номер рабочего потока, чтобы использовать его ресурсы
+    using Task = std::function<void(size_t workerIndex)>;
+
+    explicit ThreadPool(size_t threadCount);
+    ~ThreadPool(); // Дожидается всех задач и останавливает потоки
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Добавляет задачу. Из рабочего потока - в его собственную очередь,
+    // извне - в очереди по кругу
+    void submit(Task task);
+
+    // Блокирует вызывающий поток, пока не будут выполнены все задачи
+    void wait();
+
+    size_t size() const { return threads_.size(); }
+
+private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues_;
+    std::vector<std::thread> threads_;
+
+    std::mutex stateMutex_;
+    std::condition_variable workAvailable_;
+    std::condition_variable allDone_;
+    std::atomic<size_t> queued_;  // Задачи, лежащие в очередях
+    std::atomic<size_t> pending_; // Задачи в очередях плюс выполняющиеся
+    std::atomic<size_t> nextQueue_;
+    bool stopping_;
+
+    void workerLoop(size_t index);
+    bool popLocal(size_t index, Task& task);
+    bool steal(size_t index, Task& task);
+};
+
+#endif
@@ -0,0 +1,162 @@
+#include "type_index.h"
+#include "utils.h"
+#include "xml_parser.h"
+#include <algorithm>
+
+void TypeIndex::clear() {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    entries_.clear();
+    typeCount_ = 0;
+}
+
+void TypeIndex::add(const std::string& file) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    insertEntry(entries_[utils::getFileNameWithoutExtension(file)], file);
+    typeCount_++;
+}
+
+void TypeIndex::insertEntry(std::vector<std::unique_ptr<Entry>>& candidates, const std::string& file) {
+    auto entry = std::make_unique<Entry>();
+    entry->path = file;
+    auto position = std::lower_bound(candidates.begin(), candidates.end(), file,
+                                     [](const std::unique_ptr<Entry>& candidate, const std::string& path) {
+                                         return candidate->path < path;
+                                     });
+    candidates.insert(position, std::move(entry));
+}
+
+std::shared_ptr<const FbInterface> TypeIndex::load(Entry& entry, bool& parsed) const {
+    std::lock_guard<std::mutex> lock(entry.mutex);
+    if (entry.loaded) {
+        return entry.fb;
+    }
+
+    bool hashed = cache_ && hashEntry(entry);
+    uint64_t hash = entry.contentHash;
+    auto fb = std::make_shared<FbInterface>();
+    if (hashed && cache_->find(hash, *fb)) {
+        fb->network = FbNetwork(); // Для рамки экземпляра достаточно интерфейса
+        entry.fb = std::move(fb);
+    } else {
+        // Отдельный парсер: парсер рабочего потока держит разбираемый составной блок
+        XmlParser parser;
+        if (parser.parseFile(entry.path)) {
+            if (hashed) {
+                cache_->store(hash, parser.getInterface());
+            }
+            *fb = parser.getInterface();
+            fb->network = FbNetwork();
+            entry.fb = std::move(fb);
+        }
+    }
+    entry.loaded = true;
+    parsed = true;
+    return entry.fb;
+}
+
+bool TypeIndex::hashEntry(Entry& entry) {
+    if (!entry.hashed) {
+        entry.hashed = utils::hashFile(entry.path, entry.contentHash);
+    }
+    return entry.hashed;
+}
+
+TypeIndex::Entry* TypeIndex::find(const std::string& typeName, bool& parsed) const {
+    size_t separator = typeName.rfind("::");
+    std::string name = separator == std::string::npos ? typeName : typeName.substr(separator + 2);
+    std::string package = separator == std::string::npos ? std::string() : typeName.substr(0, separator);
+
+    auto it = entries_.find(name);
+    if (it == entries_.end()) {
+        return nullptr;
+    }
+    const auto& candidates = it->second;
+    if (candidates.size() == 1) {
+        return candidates.front().get();
+    }
+
+    // Одноименные типы из разных пакетов различаются только после разбора;
+    // имени без пакета соответствует тип без пакета, иначе первый разобранный
+    Entry* fallback = nullptr;
+    for (const auto& candidate : candidates) {
+        std::shared_ptr<const FbInterface> fb = load(*candidate, parsed);
+        if (fb && fb->packageName == package) {
+            return candidate.get();
+        }
+        if (fb && !fallback) {
+            fallback = candidate.get();
+        }
+    }
+    return package.empty() ? fallback : nullptr;
+}
+
+std::shared_ptr<const FbInterface> TypeIndex::resolve(const std::string& typeName) const {
+    std::shared_ptr<const FbInterface> result;
+    bool parsed = false;
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        Entry* entry = find(typeName, parsed);
+        if (entry) {
+            result = load(*entry, parsed);
+        }
+    }
+
+    if (!result) {
+        unresolved_++;
+    } else if (parsed) {
+        misses_++;
+    } else {
+        hits_++;
+    }
+    return result;
+}
+
+bool TypeIndex::locate(const std::string& typeName, std::string& path, uint64_t& contentHash) const {
+    bool parsed = false;
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    Entry* entry = find(typeName, parsed);
+    if (!entry) {
+        return false;
+    }
+    std::lock_guard<std::mutex> entryLock(entry->mutex);
+    path = entry->path;
+    contentHash = hashEntry(*entry) ? entry->contentHash : 0;
+    return true;
+}
+
+void TypeIndex::update(const std::string& file) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    std::vector<std::unique_ptr<Entry>>& candidates = entries_[utils::getFileNameWithoutExtension(file)];
+    auto it = std::find_if(candidates.begin(), candidates.end(),
+                           [&file](const std::unique_ptr<Entry>& entry) { return entry->path == file; });
+
+    if (!utils::fileExists(file)) {
+        if (it != candidates.end()) {
+            candidates.erase(it);
+            typeCount_--;
+        }
+        return;
+    }
+
+    if (it == candidates.end()) {
+        insertEntry(candidates, file);
+        typeCount_++;
+    } else {
+        // Блокировка записи не нужна: читателей нет, пока удерживается mutex_
+        (*it)->loaded = false;
+        (*it)->fb.reset();
+        (*it)->hashed = false;
+    }
+}
+
+TypeIndexStats TypeIndex::getStats() const {
+    TypeIndexStats stats;
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        stats.types = typeCount_;
+    }
+    stats.hits = hits_;
+    stats.misses = misses_;
+    stats.unresolved = unresolved_;
+    return stats;
+}
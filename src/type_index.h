@@ -0,0 +1,82 @@
+#ifndef TYPE_INDEX_H
+#define TYPE_INDEX_H
+
+#include "fb_interface.h"
+#include "interface_cache.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Статистика обращений к индексу типов
+struct TypeIndexStats {
+    size_t types = 0;      // Известные файлы типов
+    size_t hits = 0;       // Интерфейс взят из кэша
+    size_t misses = 0;     // Интерфейс пришлось разобрать из файла
+    size_t unresolved = 0; // Тип не найден или его файл не разобрался
+};
+
+// Индекс типов библиотеки: имя типа -> интерфейс FB.
+// Заполняется по ходу обхода входного дерева, без разбора файлов; файл типа
+// разбирается при первом обращении, дальше интерфейс отдается из кэша.
+// Имя типа - имя файла без расширения (в 4diac оно совпадает с атрибутом Name).
+// Если файлов с таким именем несколько, имя с пакетом ("pkg::sub::NAME")
+// сверяется с CompilerInfo packageName, а имени без пакета соответствует тип без пакета.
+// resolve() можно вызывать из нескольких потоков: разные типы разбираются
+// параллельно, один и тот же тип - один раз.
+class TypeIndex {
+public:
+    void clear();
+    // Файл типа из обхода; можно вызывать одновременно с resolve()
+    void add(const std::string& file);
+
+    // nullptr, если тип неизвестен или файл не удалось разобрать
+    std::shared_ptr<const FbInterface> resolve(const std::string& typeName) const;
+    // Файл типа и хеш его содержимого - для проверки, не устарела ли сеть.
+    // Файл разбирается, только если одноименных типов несколько и нужно сверить
+    // пакет; false - тип неизвестен. В статистику не входит
+    bool locate(const std::string& typeName, std::string& path, uint64_t& contentHash) const;
+
+    // Режим наблюдения: файл типа изменился, появился или удален
+    void update(const std::string& file);
+
+    // Разобранные интерфейсы берутся из кэша и добавляются в него; nullptr - без кэша
+    void setCache(InterfaceCache* cache) { cache_ = cache; }
+
+    TypeIndexStats getStats() const;
+
+private:
+    struct Entry {
+        std::string path;
+        std::mutex mutex;
+        bool loaded = false;
+        std::shared_ptr<const FbInterface> fb;
+        bool hashed = false; // contentHash посчитан; считается при первой надобности
+        uint64_t contentHash = 0;
+    };
+
+    // Интерфейс записи; parsed - был ли файл разобран в этом вызове
+    std::shared_ptr<const FbInterface> load(Entry& entry, bool& parsed) const;
+    // Одноименные типы хранятся по пути файла: выбор между ними не зависит от порядка обхода
+    static void insertEntry(std::vector<std::unique_ptr<Entry>>& candidates, const std::string& file);
+    // Хеш содержимого в entry.contentHash; false - файл не прочитан. Вызывается под entry.mutex
+    static bool hashEntry(Entry& entry);
+    // Запись, соответствующая имени типа; одноименные типы для сверки пакета
+    // разбираются, единственный - нет. Вызывается под mutex_
+    Entry* find(const std::string& typeName, bool& parsed) const;
+
+    mutable std::shared_mutex mutex_; // Исключительная блокировка - только в update()
+    std::unordered_map<std::string, std::vector<std::unique_ptr<Entry>>> entries_;
+    size_t typeCount_ = 0;
+    InterfaceCache* cache_ = nullptr;
+    mutable std::atomic<size_t> hits_{0};
+    mutable std::atomic<size_t> misses_{0};
+    mutable std::atomic<size_t> unresolved_{0};
+};
+
+#endif
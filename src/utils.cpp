@@ -2,34 +2,33 @@
 #include <filesystem>
 #include <iostream>
 #include <algorithm>
+#include <cstdio>
+#include <fstream>
 
 namespace utils {
+    namespace {
+        thread_local std::ostream* currentLogOut = nullptr;
+        thread_local std::ostream* currentLogErr = nullptr;
+    }
+
     std::vector<std::string> getFilesInDirectory(const std::string& directoryPath, const std::string& extension) {
         std::vector<std::string> files;
         
-        std::cout << "DEBUG: Looking for files in: " << directoryPath << std::endl;
-        std::cout << "DEBUG: Looking for extension: " << extension << std::endl;
-        
         // Проверяем существование директории
-        if (!std::filesystem::exists(directoryPath)) {
-            std::cerr << "Directory does not exist: " << directoryPath << std::endl;
-            return files;
-        }
-        
         if (!std::filesystem::is_directory(directoryPath)) {
-            std::cerr << "Path is not a directory: " << directoryPath << std::endl;
+            logErr() << "Directory does not exist: " << directoryPath << std::endl;
             return files;
         }
         
+        // Расширения сравниваются без учета регистра; образец приводится один раз
+        std::string extLower = extension;
+        std::transform(extLower.begin(), extLower.end(), extLower.begin(), ::tolower);
+        
         try {
             for (const auto& entry : std::filesystem::directory_iterator(directoryPath)) {
                 if (entry.is_regular_file()) {
                     std::string fileExtension = entry.path().extension().string();
-                    
-                    // Сравниваем расширения без учета регистра
-                    std::string extLower = extension;
                     std::transform(fileExtension.begin(), fileExtension.end(), fileExtension.begin(), ::tolower);
-                    std::transform(extLower.begin(), extLower.end(), extLower.begin(), ::tolower);
                     
                     if (fileExtension == extLower) {
                         files.push_back(entry.path().string());
@@ -41,10 +40,9 @@ namespace utils {
             std::sort(files.begin(), files.end());
             
         } catch (const std::filesystem::filesystem_error& e) {
-            std::cerr << "Error accessing directory: " << directoryPath << " - " << e.what() << std::endl;
+            logErr() << "Error accessing directory: " << directoryPath << " - " << e.what() << std::endl;
         }
         
-        std::cout << "DEBUG: Total " << extension << " files found: " << files.size() << std::endl;
         return files;
     }
 
@@ -59,8 +57,118 @@ namespace utils {
 
     void createDirectoryIfNotExists(const std::string& directoryPath) {
         if (!std::filesystem::exists(directoryPath)) {
-            std::cout << "Creating directory: " << directoryPath << std::endl;
+            logOut() << "Creating directory: " << directoryPath << std::endl;
             std::filesystem::create_directories(directoryPath);
         }
     }
+
+    std::u32string decodeUtf8(const std::string& text) {
+        std::u32string result;
+        result.reserve(text.size());
+        
+        size_t i = 0;
+        while (i < text.size()) {
+            unsigned char lead = static_cast<unsigned char>(text[i]);
+            
+            // Однобайтовый символ (ASCII) - самый частый случай
+            if (lead < 0x80) {
+                result.push_back(lead);
+                i++;
+                continue;
+            }
+            
+            // Определяем длину последовательности и минимальное значение
+            // (для отбрасывания избыточно длинных кодировок)
+            size_t length = 0;
+            char32_t codepoint = 0;
+            char32_t minValue = 0;
+            if ((lead & 0xE0) == 0xC0) {
+                length = 2; codepoint = lead & 0x1F; minValue = 0x80;
+            } else if ((lead & 0xF0) == 0xE0) {
+                length = 3; codepoint = lead & 0x0F; minValue = 0x800;
+            } else if ((lead & 0xF8) == 0xF0) {
+                length = 4; codepoint = lead & 0x07; minValue = 0x10000;
+            } else {
+                result.push_back(0xFFFD);
+                i++;
+                continue;
+            }
+            
+            size_t consumed = 1;
+            bool valid = true;
+            for (; consumed < length; consumed++) {
+                if (i + consumed >= text.size()) {
+                    valid = false;
+                    break;
+                }
+                unsigned char next = static_cast<unsigned char>(text[i + consumed]);
+                if ((next & 0xC0) != 0x80) {
+                    valid = false;
+                    break;
+                }
+                codepoint = (codepoint << 6) | (next & 0x3F);
+            }
+            
+            if (!valid || codepoint < minValue || codepoint > 0x10FFFF ||
+                (codepoint >= 0xD800 && codepoint <= 0xDFFF)) {
+                result.push_back(0xFFFD);
+            } else {
+                result.push_back(codepoint);
+            }
+            i += consumed;
+        }
+        
+        return result;
+    }
+
+    std::ostream& logOut() {
+        return currentLogOut ? *currentLogOut : std::cout;
+    }
+
+    std::ostream& logErr() {
+        return currentLogErr ? *currentLogErr : std::cerr;
+    }
+
+    // Обычный вывод и ошибки пишутся в один буфер, чтобы сохранить их порядок
+    ScopedLogCapture::ScopedLogCapture() : previousOut_(currentLogOut), previousErr_(currentLogErr) {
+        currentLogOut = &buffer_;
+        currentLogErr = &buffer_;
+    }
+
+    ScopedLogCapture::~ScopedLogCapture() {
+        currentLogOut = previousOut_;
+        currentLogErr = previousErr_;
+    }
+
+    uint64_t hashBytes(const void* data, size_t size, uint64_t seed) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        uint64_t hash = seed;
+        for (size_t i = 0; i < size; i++) {
+            hash ^= bytes[i];
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+
+    bool hashFile(const std::string& filePath, uint64_t& hash) {
+        std::ifstream in(filePath, std::ios::binary);
+        if (!in) {
+            return false;
+        }
+        
+        // Читаем блоками, чтобы не держать файл в памяти целиком
+        char buffer[65536];
+        hash = hashBytes(nullptr, 0);
+        while (in) {
+            in.read(buffer, sizeof(buffer));
+            hash = hashBytes(buffer, static_cast<size_t>(in.gcount()), hash);
+        }
+        return !in.bad();
+    }
+
+    std::string formatHash(uint64_t hash) {
+        char text[17];
+        std::snprintf(text, sizeof(text), "%016llx", static_cast<unsigned long long>(hash));
+        return text;
+    }
 }
\ No newline at end of file
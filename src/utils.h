@@ -1,13 +1,17 @@
 #ifndef UTILS_H
 #define UTILS_H
 
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <sstream>
 #include <string>
 #include <vector>
 
 namespace utils {
-    // Ищет файлы с заданным расширением в указанной директории
-    // Проверяет несколько возможных мест расположения файлов .fbt
-    // Возвращает вектор с полными путями к найденным файлам
+    // Ищет файлы с заданным расширением в указанной директории (без поддиректорий)
+    // Рекурсивный поиск с масками - FileDiscovery
+    // Возвращает отсортированный вектор с путями к найденным файлам
     std::vector<std::string> getFilesInDirectory(const std::string& directoryPath, const std::string& extension = ".xml");
     
     // Проверяет, существует ли файл по указанному пути
@@ -19,6 +23,41 @@ namespace utils {
     
     // Создает директорию, если она не существует
     void createDirectoryIfNotExists(const std::string& directoryPath);
+    
+    // Декодирует UTF-8 строку в последовательность кодовых точек Unicode
+    // Некорректные байты заменяются символом U+FFFD
+    std::u32string decodeUtf8(const std::string& text);
+    
+    // 64-битный хеш FNV-1a; seed позволяет продолжить хеширование по частям
+    uint64_t hashBytes(const void* data, size_t size, uint64_t seed = 14695981039346656037ULL);
+    
+    // Хеш содержимого файла; возвращает false, если файл не удалось прочитать
+    bool hashFile(const std::string& filePath, uint64_t& hash);
+    
+    // Хеш в виде 16 шестнадцатеричных цифр
+    std::string formatHash(uint64_t hash);
+    
+    // Журнал текущего потока: по умолчанию std::cout и std::cerr
+    // Используется вместо прямого вывода, чтобы пакетная обработка могла
+    // собирать сообщения каждого файла в отдельный буфер
+    std::ostream& logOut();
+    std::ostream& logErr();
+    
+    // Перенаправляет журнал текущего потока в буфер на время жизни объекта
+    class ScopedLogCapture {
+    public:
+        ScopedLogCapture();
+        ~ScopedLogCapture();
+        ScopedLogCapture(const ScopedLogCapture&) = delete;
+        ScopedLogCapture& operator=(const ScopedLogCapture&) = delete;
+        
+        std::string str() const { return buffer_.str(); }
+        
+    private:
+        std::ostringstream buffer_;
+        std::ostream* previousOut_;
+        std::ostream* previousErr_;
+    };
 }
 
 #endif
\ No newline at end of file
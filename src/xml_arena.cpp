@@ -0,0 +1,53 @@
+#include "xml_arena.h"
+#include <cstring>
+
+XmlArena::XmlArena(size_t blockSize)
+    : blockSize_(blockSize) {}
+
+void* XmlArena::allocate(size_t size, size_t alignment) {
+    while (current_ < blocks_.size()) {
+        Block& block = blocks_[current_];
+        size_t start = (offset_ + alignment - 1) & ~(alignment - 1);
+        if (start + size <= block.size) {
+            offset_ = start + size;
+            usedBytes_ += size;
+            return block.data.get() + start;
+        }
+        // Блок исчерпан - переходим к следующему, оставшемуся после reset()
+        current_++;
+        offset_ = 0;
+    }
+
+    // Крупные запросы получают отдельный блок нужного размера
+    Block block;
+    block.size = size + alignment > blockSize_ ? size + alignment : blockSize_;
+    block.data.reset(new char[block.size]);
+    reservedBytes_ += block.size;
+    blocks_.push_back(std::move(block));
+    current_ = blocks_.size() - 1;
+    offset_ = 0;
+    return allocate(size, alignment);
+}
+
+std::string_view XmlArena::copyString(std::string_view text) {
+    char* copy = static_cast<char*>(allocate(text.size() + 1, 1));
+    std::memcpy(copy, text.data(), text.size());
+    copy[text.size()] = '\0';
+    return std::string_view(copy, text.size());
+}
+
+void XmlArena::reset() {
+    current_ = 0;
+    offset_ = 0;
+    usedBytes_ = 0;
+}
+
+std::string_view XmlNameTable::intern(std::string_view name) {
+    auto it = names_.find(name);
+    if (it != names_.end()) {
+        return *it;
+    }
+    std::string_view stored = storage_.copyString(name);
+    names_.insert(stored);
+    return stored;
+}
@@ -0,0 +1,74 @@
+#ifndef XML_ARENA_H
+#define XML_ARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+// Линейный распределитель памяти для дерева XmlNode.
+// Память выделяется блоками и освобождается только целиком; reset() оставляет
+// блоки себе, поэтому повторный разбор не обращается к куче.
+// Подходит только для тривиально разрушаемых типов.
+class XmlArena {
+public:
+    explicit XmlArena(size_t blockSize = 4096);
+    XmlArena(const XmlArena&) = delete;
+    XmlArena& operator=(const XmlArena&) = delete;
+
+    void* allocate(size_t size, size_t alignment);
+
+    template <typename T>
+    T* allocateArray(size_t count) {
+        if (count == 0) {
+            return nullptr;
+        }
+        T* items = static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+        for (size_t i = 0; i < count; i++) {
+            new (items + i) T();
+        }
+        return items;
+    }
+
+    // Строка с нулевым окончанием в памяти арены
+    std::string_view copyString(std::string_view text);
+
+    void reset();
+
+    size_t getUsedBytes() const { return usedBytes_; }
+    size_t getReservedBytes() const { return reservedBytes_; }
+    size_t getBlockCount() const { return blocks_.size(); }
+
+private:
+    struct Block {
+        std::unique_ptr<char[]> data;
+        size_t size;
+    };
+
+    size_t blockSize_;
+    std::vector<Block> blocks_;
+    size_t current_ = 0; // Блок, из которого идет выделение
+    size_t offset_ = 0;  // Занятая часть текущего блока
+    size_t usedBytes_ = 0;
+    size_t reservedBytes_ = 0;
+};
+
+// Таблица интернированных имен элементов и атрибутов.
+// Каждое имя хранится один раз; одинаковые имена дают один и тот же указатель.
+// Имена не удаляются: их немного (Event, VarDeclaration, Name, Type...),
+// и таблица переживает разбор отдельных файлов.
+class XmlNameTable {
+public:
+    std::string_view intern(std::string_view name);
+
+    size_t size() const { return names_.size(); }
+    size_t getReservedBytes() const { return storage_.getReservedBytes(); }
+
+private:
+    XmlArena storage_{1024};
+    std::unordered_set<std::string_view> names_;
+};
+
+#endif
@@ -1,101 +1,263 @@
 #include "xml_parser.h"
 #include "pugixml.hpp"
+#include "utils.h"
+#include <cstring>
 #include <iostream>
 
-XmlParser::XmlParser() {}
+static const XmlNode EMPTY_NODE;
 
-// Рекурсивная функция для парсинга узла
-XmlNode parseNodeRecursive(pugi::xml_node xmlNode) {
-    XmlNode node;
-    node.name = xmlNode.name();
-    node.value = xmlNode.child_value();
+XmlParser::XmlParser()
+    : rootNode_(&EMPTY_NODE),
+      document_(std::make_unique<pugi::xml_document>()) {}
+
+XmlParser::~XmlParser() = default;
+
+std::string_view XmlNode::getAttribute(std::string_view attributeName) const {
+    for (size_t i = 0; i < attributeCount; i++) {
+        const XmlAttribute& attr = attributes[i];
+        if (attr.name == attributeName) {
+            return attr.value;
+        }
+    }
+    return std::string_view();
+}
+
+// Чтение списка событий (EventInputs / EventOutputs)
+static void extractEvents(pugi::xml_node list, std::vector<FbEvent>& events) {
+    for (pugi::xml_node event = list.child("Event"); event; event = event.next_sibling("Event")) {
+        FbEvent fbEvent;
+        fbEvent.name = event.attribute("Name").as_string("Unnamed");
+        fbEvent.type = event.attribute("Type").as_string("Event");
+        fbEvent.comment = event.attribute("Comment").as_string();
+        for (pugi::xml_node with = event.child("With"); with; with = with.next_sibling("With")) {
+            fbEvent.with.push_back(with.attribute("Var").as_string());
+        }
+        events.push_back(std::move(fbEvent));
+    }
+}
+
+// Чтение списка переменных (InputVars / OutputVars)
+static void extractVars(pugi::xml_node list, std::vector<FbVar>& vars) {
+    for (pugi::xml_node var = list.child("VarDeclaration"); var; var = var.next_sibling("VarDeclaration")) {
+        FbVar fbVar;
+        fbVar.name = var.attribute("Name").as_string("Unnamed");
+        fbVar.type = var.attribute("Type").as_string("Unknown");
+        fbVar.comment = var.attribute("Comment").as_string();
+        fbVar.arraySize = var.attribute("ArraySize").as_string();
+        fbVar.initialValue = var.attribute("InitialValue").as_string();
+        vars.push_back(std::move(fbVar));
+    }
+}
+
+// Сеть составного блока: экземпляры FB/SubApp и списки соединений
+static void extractNetwork(pugi::xml_node networkNode, FbNetwork& network) {
+    for (pugi::xml_node child = networkNode.first_child(); child; child = child.next_sibling()) {
+        const char* name = child.name();
+        if (std::strcmp(name, "FB") == 0 || std::strcmp(name, "SubApp") == 0) {
+            FbInstance instance;
+            instance.name = child.attribute("Name").as_string();
+            instance.type = child.attribute("Type").as_string();
+            instance.x = child.attribute("x").as_double();
+            instance.y = child.attribute("y").as_double();
+            network.instances.push_back(std::move(instance));
+            continue;
+        }
+        
+        FbConnectionKind kind;
+        if (std::strcmp(name, "EventConnections") == 0) {
+            kind = FbConnectionKind::Event;
+        } else if (std::strcmp(name, "DataConnections") == 0) {
+            kind = FbConnectionKind::Data;
+        } else if (std::strcmp(name, "AdapterConnections") == 0) {
+            kind = FbConnectionKind::Adapter;
+        } else {
+            continue;
+        }
+        for (pugi::xml_node connection = child.child("Connection"); connection;
+             connection = connection.next_sibling("Connection")) {
+            FbConnection fbConnection;
+            fbConnection.source = connection.attribute("Source").as_string();
+            fbConnection.destination = connection.attribute("Destination").as_string();
+            fbConnection.kind = kind;
+            network.connections.push_back(std::move(fbConnection));
+        }
+    }
+}
+
+// Заполнение интерфейса FB за один проход по корневому элементу
+static void extractInterface(pugi::xml_node root, FbInterface& fb) {
+    fb.name = root.attribute("Name").as_string("Unknown");
+    fb.comment = root.attribute("Comment").as_string();
+    fb.version = "1.0";
     
-    // Парсим атрибуты
-    for (auto attr : xmlNode.attributes()) {
-        node.attributes[attr.name()] = attr.value();
+    for (pugi::xml_node child = root.first_child(); child; child = child.next_sibling()) {
+        const char* name = child.name();
+        if (std::strcmp(name, "VersionInfo") == 0) {
+            // При нескольких VersionInfo берется последняя
+            pugi::xml_attribute version = child.attribute("Version");
+            if (version) {
+                fb.version = version.value();
+            }
+        } else if (std::strcmp(name, "CompilerInfo") == 0) {
+            fb.packageName = child.attribute("packageName").as_string();
+        } else if (std::strcmp(name, "InterfaceList") == 0) {
+            for (pugi::xml_node list = child.first_child(); list; list = list.next_sibling()) {
+                const char* listName = list.name();
+                if (std::strcmp(listName, "EventInputs") == 0) {
+                    extractEvents(list, fb.eventInputs);
+                } else if (std::strcmp(listName, "EventOutputs") == 0) {
+                    extractEvents(list, fb.eventOutputs);
+                } else if (std::strcmp(listName, "InputVars") == 0) {
+                    extractVars(list, fb.inputVars);
+                } else if (std::strcmp(listName, "OutputVars") == 0) {
+                    extractVars(list, fb.outputVars);
+                }
+            }
+        } else if (std::strcmp(name, "FBNetwork") == 0) {
+            extractNetwork(child, fb.network);
+        }
     }
+}
+
+// Общая часть parseFile и parseBuffer: проверка результата загрузки и извлечение интерфейса
+static bool extractDocument(const pugi::xml_document& doc, const pugi::xml_parse_result& result, FbInterface& fb) {
+    if (!result) {
+        utils::logErr() << "XML parsing error: " << result.description() << std::endl;
+        return false;
+    }
+    
+    fb = FbInterface();
     
-    // Рекурсивно парсим дочерние узлы
-    for (auto child : xmlNode.children()) {
-        XmlNode childNode = parseNodeRecursive(child);
-        node.children.push_back(childNode);
+    auto root = doc.document_element();
+    if (root) {
+        extractInterface(root, fb);
     }
     
-    return node;
+    return true;
+}
+
+// Разбор файла на месте: строки DOM указывают прямо в отображение,
+// поэтому оно живет до следующей загрузки в тот же документ
+static pugi::xml_parse_result loadMappedFile(pugi::xml_document& doc, MappedFile& input, const std::string& filePath) {
+    if (!input.open(filePath)) {
+        doc.reset();
+        pugi::xml_parse_result result;
+        result.status = pugi::status_file_not_found;
+        return result;
+    }
+    static char empty = '\0';
+    return doc.load_buffer_inplace(input.size() > 0 ? input.data() : &empty, input.size());
 }
 
 bool XmlParser::parseFile(const std::string& filePath) {
-    pugi::xml_document doc;
-    pugi::xml_parse_result result = doc.load_file(filePath.c_str());
+    clearTree(); // Дерево ссылается на буфер, который сейчас будет заменен
+    pugi::xml_parse_result result = loadMappedFile(*document_, input_, filePath);
+    return extractDocument(*document_, result, interface_);
+}
+
+bool XmlParser::parseBuffer(const char* data, size_t size) {
+    clearTree();
+    pugi::xml_parse_result result = document_->load_buffer(data, size);
+    return extractDocument(*document_, result, interface_);
+}
+
+const FbInterface& XmlParser::getInterface() const {
+    return interface_;
+}
+
+bool XmlParser::parseTree(const std::string& filePath) {
+    clearTree();
+    
+    pugi::xml_document& doc = *document_;
+    pugi::xml_parse_result result = loadMappedFile(doc, input_, filePath);
     
     if (!result) {
-        std::cerr << "XML parsing error: " << result.description() << std::endl;
+        utils::logErr() << "XML parsing error: " << result.description() << std::endl;
         return false;
     }
     
-    // Очищаем предыдущее дерево
-    rootNode_ = XmlNode();
-    
-    // Рекурсивно парсим XML с корневого элемента
     auto root = doc.document_element();
     if (root) {
-        rootNode_ = parseNodeRecursive(root);
-        std::cout << "DEBUG PARSER: Successfully parsed XML with root: " << rootNode_.name << std::endl;
-        std::cout << "DEBUG PARSER: Root has " << rootNode_.children.size() << " direct children" << std::endl;
-        
-        // Отладочный вывод структуры
-        printParsingDebugInfo(rootNode_);
+        XmlNode* node = treeArena_.allocateArray<XmlNode>(1);
+        buildNode(root, *node);
+        rootNode_ = node;
     }
     
+    treeStats_.arenaUsedBytes = treeArena_.getUsedBytes();
+    treeStats_.arenaReservedBytes = treeArena_.getReservedBytes();
+    treeStats_.arenaBlocks = treeArena_.getBlockCount();
+    treeStats_.internedNames = names_.size();
     return true;
 }
 
-// Вспомогательная функция для отладочного вывода структуры
-void XmlParser::printParsingDebugInfo(const XmlNode& node, int depth) {
-    std::string indent(depth * 2, ' ');
-    std::cout << "DEBUG PARSER: " << indent << "Node: " << node.name;
+void XmlParser::clearTree() {
+    rootNode_ = &EMPTY_NODE;
+    treeArena_.reset();
+    treeStats_ = XmlTreeStats();
+}
+
+// Дети и атрибуты узла кладутся в арену непрерывными массивами:
+// сначала подсчет, затем заполнение
+void XmlParser::buildNode(const pugi::xml_node& source, XmlNode& node) {
+    node.name = names_.intern(source.name());
+    node.value = source.child_value();
+    treeStats_.nodeCount++;
     
-    if (!node.attributes.empty()) {
-        std::cout << " [";
-        for (const auto& attr : node.attributes) {
-            std::cout << attr.first << "=" << attr.second << " ";
-        }
-        std::cout << "]";
+    size_t attributeCount = 0;
+    for (pugi::xml_attribute attr = source.first_attribute(); attr; attr = attr.next_attribute()) {
+        attributeCount++;
     }
-    
-    if (!node.value.empty()) {
-        std::cout << " Value: " << node.value;
+    XmlAttribute* attributes = treeArena_.allocateArray<XmlAttribute>(attributeCount);
+    size_t index = 0;
+    for (pugi::xml_attribute attr = source.first_attribute(); attr; attr = attr.next_attribute()) {
+        attributes[index].name = names_.intern(attr.name());
+        attributes[index].value = attr.value();
+        index++;
     }
+    node.attributes = attributes;
+    node.attributeCount = attributeCount;
+    treeStats_.attributeCount += attributeCount;
     
-    std::cout << " Children: " << node.children.size() << std::endl;
-    
-    for (const auto& child : node.children) {
-        printParsingDebugInfo(child, depth + 1);
+    size_t childCount = 0;
+    for (pugi::xml_node child = source.first_child(); child; child = child.next_sibling()) {
+        childCount++;
+    }
+    XmlNode* children = treeArena_.allocateArray<XmlNode>(childCount);
+    index = 0;
+    for (pugi::xml_node child = source.first_child(); child; child = child.next_sibling()) {
+        buildNode(child, children[index++]);
     }
+    node.children = children;
+    node.childCount = childCount;
 }
 
 const XmlNode& XmlParser::getRootNode() const {
-    return rootNode_;
+    return *rootNode_;
+}
+
+XmlTreeStats XmlParser::getTreeStats() const {
+    return treeStats_;
 }
 
 void XmlParser::printTree() const {
-    std::cout << "XML Tree Structure:" << std::endl;
-    printNode(rootNode_);
+    utils::logOut() << "XML Tree Structure:" << std::endl;
+    printNode(*rootNode_);
 }
 
 void XmlParser::printNode(const XmlNode& node, int depth) const {
     std::string indent(depth * 2, ' ');
-    std::cout << indent << "Node: " << node.name << std::endl;
+    utils::logOut() << indent << "Node: " << node.name << std::endl;
     
     if (!node.value.empty()) {
-        std::cout << indent << "  Value: " << node.value << std::endl;
+        utils::logOut() << indent << "  Value: " << node.value << std::endl;
     }
     
-    for (const auto& attr : node.attributes) {
-        std::cout << indent << "  Attribute: " << attr.first << " = " << attr.second << std::endl;
+    for (size_t i = 0; i < node.attributeCount; i++) {
+        const XmlAttribute& attr = node.attributes[i];
+        utils::logOut() << indent << "  Attribute: " << attr.name << " = " << attr.value << std::endl;
     }
     
-    for (const auto& child : node.children) {
-        printNode(child, depth + 1);
+    for (size_t i = 0; i < node.childCount; i++) {
+        printNode(node.children[i], depth + 1);
     }
-}
\ No newline at end of file
+}
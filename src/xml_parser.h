@@ -1,31 +1,81 @@
 #ifndef XML_PARSER_H
 #define XML_PARSER_H
 
+#include "fb_interface.h"
+#include "mapped_file.h"
+#include "xml_arena.h"
+#include <memory>
 #include <string>
-#include <vector>
-#include <map>
+#include <string_view>
 
+namespace pugi {
+    class xml_document;
+    class xml_node;
+}
+
+// Атрибут элемента: имя интернировано, значение указывает в буфер документа
+struct XmlAttribute {
+    std::string_view name;
+    std::string_view value;
+};
+
+// Узел обобщенного дерева XML. Узлы, атрибуты и списки детей лежат в арене
+// парсера; значения указывают прямо в разобранный на месте буфер файла.
+// Дерево действительно до следующего вызова parse* того же парсера.
 struct XmlNode {
-    std::string name;
-    std::string value;
-    std::map<std::string, std::string> attributes;
-    std::vector<XmlNode> children;
+    std::string_view name;  // Интернированное имя элемента
+    std::string_view value; // Текст первого текстового потомка
+    const XmlAttribute* attributes = nullptr;
+    size_t attributeCount = 0;
+    const XmlNode* children = nullptr;
+    size_t childCount = 0;
+
+    // Линейный поиск: у элементов FBT всего несколько атрибутов.
+    // Пустая строка, если атрибута нет
+    std::string_view getAttribute(std::string_view attributeName) const;
+};
+
+// Расход памяти последнего дерева XmlNode
+struct XmlTreeStats {
+    size_t nodeCount = 0;
+    size_t attributeCount = 0;
+    size_t arenaUsedBytes = 0;     // Занято узлами и атрибутами
+    size_t arenaReservedBytes = 0; // Выделено блоками арены (пик - арена не сжимается)
+    size_t arenaBlocks = 0;        // Число обращений арены к куче
+    size_t internedNames = 0;
 };
 
 class XmlParser {
 public:
     XmlParser();
-    ~XmlParser() = default;
+    ~XmlParser();
     
+    // Извлекает интерфейс FB напрямую из DOM, без построения дерева XmlNode.
+    // Файл отображается в память и разбирается на месте; документ и
+    // отображение переиспользуются от файла к файлу
     bool parseFile(const std::string& filePath);
+    // То же для документа в памяти (например, присланного клиентом сервера)
+    bool parseBuffer(const char* data, size_t size);
+    const FbInterface& getInterface() const;
+    
+    // Строит полное дерево XmlNode - для вызывающих, которым нужен весь документ
+    bool parseTree(const std::string& filePath);
     const XmlNode& getRootNode() const;
+    XmlTreeStats getTreeStats() const;
     void printTree() const;
     
 private:
-    XmlNode rootNode_;
+    FbInterface interface_;
+    const XmlNode* rootNode_;
+    XmlArena treeArena_;
+    XmlNameTable names_;
+    XmlTreeStats treeStats_;
+    std::unique_ptr<pugi::xml_document> document_;
+    MappedFile input_;
     
+    void clearTree();
+    void buildNode(const pugi::xml_node& source, XmlNode& node);
     void printNode(const XmlNode& node, int depth = 0) const;
-    void printParsingDebugInfo(const XmlNode& node, int depth = 0);
 };
 
-#endif
\ No newline at end of file
+#endif